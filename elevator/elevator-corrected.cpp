@@ -62,6 +62,28 @@ Answer 6: The revised design adopts the following strategy for scheduling.
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <stdexcept>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <deque>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 
 
 using namespace std;
@@ -70,6 +92,336 @@ enum ElevatorDirection {
 	UP, DOWN
 };
 
+// a set of floors as a flat bitset, with find-first-set lookups above/below a floor
+class FloorSet {
+private:
+	vector<unsigned long long> words;
+	
+public:
+	FloorSet(int maxFloor = 0) : words(maxFloor / 64 + 1, 0) {}
+	
+	void set(int floor){
+		words[floor >> 6] |= 1ULL << (floor & 63);
+	}
+	
+	void reset(int floor){
+		words[floor >> 6] &= ~(1ULL << (floor & 63));
+	}
+	
+	bool test(int floor) const {
+		return (words[floor >> 6] >> (floor & 63)) & 1;
+	}
+	
+	bool any() const {
+		for (unsigned long long w : words)
+			if (w)
+				return true;
+		return false;
+	}
+	
+	int count() const {
+		int n = 0;
+		for (unsigned long long w : words)
+			n += __builtin_popcountll(w);
+		return n;
+	}
+	
+	void clear(){
+		fill(words.begin(), words.end(), 0);
+	}
+	
+	// lowest floor >= "floor" in the set, or -1
+	int next(int floor) const {
+		int i = floor >> 6;
+		if (i >= (int)words.size())
+			return -1;
+		unsigned long long w = words[i] & (~0ULL << (floor & 63));
+		while (true){
+			if (w)
+				return (i << 6) + __builtin_ctzll(w);
+			if (++i == (int)words.size())
+				return -1;
+			w = words[i];
+		}
+	}
+	
+	// highest floor <= "floor" in the set, or -1
+	int prev(int floor) const {
+		if (floor < 0)
+			return -1;
+		int i = min(floor >> 6, (int)words.size() - 1);
+		unsigned long long w = words[i];
+		if (i == floor >> 6 && (floor & 63) != 63)
+			w &= (1ULL << ((floor & 63) + 1)) - 1;
+		while (true){
+			if (w)
+				return (i << 6) + 63 - __builtin_clzll(w);
+			if (--i < 0)
+				return -1;
+			w = words[i];
+		}
+	}
+};
+
+// counts of durations in whole ticks, for wait and ride time distributions
+class TickHistogram {
+private:
+	vector<long long> counts;   // counts[t] = how many durations of t ticks
+	long long total;
+	long long sum;
+	
+public:
+	TickHistogram() : total(0), sum(0) {}
+	
+	void add(long long ticks){
+		if (ticks >= (long long)counts.size())
+			counts.resize(max(ticks + 1, 2 * (long long)counts.size()), 0);
+		counts[ticks]++;
+		total++;
+		sum += ticks;
+	}
+	
+	void clear(){
+		counts.clear();
+		total = sum = 0;
+	}
+	
+	void merge(const TickHistogram& other){
+		if (other.counts.size() > counts.size())
+			counts.resize(other.counts.size(), 0);
+		for (size_t t = 0; t < other.counts.size(); t++)
+			counts[t] += other.counts[t];
+		total += other.total;
+		sum += other.sum;
+	}
+	
+	long long count() const {
+		return total;
+	}
+	
+	// how many durations of exactly t ticks
+	long long countOf(long long t) const {
+		return t < (long long)counts.size() ? counts[t] : 0;
+	}
+	
+	long long range() const {
+		return counts.size();
+	}
+	
+	double mean() const {
+		return total == 0 ? 0 : (double)sum / total;
+	}
+	
+	// smallest t with at least p of the durations <= t, p in [0, 1]
+	long long percentile(double p) const {
+		long long rank = (long long)ceil(p * total), seen = 0;
+		for (size_t t = 0; t < counts.size(); t++){
+			seen += counts[t];
+			if (seen >= max(rank, 1LL))
+				return t;
+		}
+		return 0;
+	}
+};
+
+// fixed-capacity ring buffer: allocated once, push() never allocates and overwrites the oldest entry once full
+template <typename T>
+class RingBuffer {
+private:
+	vector<T> items;
+	size_t mask;
+	long long pushed;
+	
+public:
+	// capacity is rounded up to a power of two, 0 leaves the buffer unallocated
+	RingBuffer(size_t capacity = 0) : mask(0), pushed(0) {
+		if (capacity > 0){
+			size_t n = 1;
+			while (n < capacity)
+				n <<= 1;
+			items.resize(n);
+			mask = n - 1;
+		}
+	}
+	
+	void push(const T& item){
+		items[pushed & mask] = item;
+		pushed++;
+	}
+	
+	size_t capacity() const {
+		return items.size();
+	}
+	
+	size_t size() const {
+		return min((size_t)pushed, items.size());
+	}
+	
+	// entries pushed over the buffer's lifetime, and how many of them have been overwritten
+	long long total() const {
+		return pushed;
+	}
+	
+	long long overwritten() const {
+		return pushed - size();
+	}
+	
+	// i-th oldest entry still held
+	const T& operator[](size_t i) const {
+		return items[(pushed - size() + i) & mask];
+	}
+};
+
+/* HDR-style histogram: values are bucketed log-linearly, exact below 2 * subBuckets and within
+   1 / subBuckets relative error above, in a count array sized up front for [0, highest]. So add() is a
+   count-leading-zeros and an increment, memory does not grow with the values, and any two histograms with
+   the same shape merge by adding counts. Values above "highest" are counted as "highest". */
+class HdrHistogram {
+private:
+	int subBucketBits;        // subBuckets = 2^subBucketBits values per power of two
+	long long highest;
+	vector<long long> counts;
+	long long total;
+	long long sum;
+	long long minValue, maxValue;
+	
+	int indexOf(long long value) const {
+		if (value < (2LL << subBucketBits))
+			return value;
+		int shift = 63 - __builtin_clzll(value) - subBucketBits;
+		return (shift << subBucketBits) + (int)(value >> shift);
+	}
+	
+	// the highest value counted at "index"
+	long long highestAt(int index) const {
+		if (index < (2 << subBucketBits))
+			return index;
+		int shift = (index >> subBucketBits) - 1;
+		long long sub = index - ((long long)shift << subBucketBits);
+		return ((sub + 1) << shift) - 1;
+	}
+	
+public:
+	// at least "significantDigits" decimal digits of precision for values up to "highestValue"
+	HdrHistogram(long long highestValue = 1 << 20, int significantDigits = 2) : total(0), sum(0), minValue(0), maxValue(0) {
+		if (highestValue < 1 || significantDigits < 1 || significantDigits > 5)
+			throw invalid_argument("histogram needs a positive range and 1 to 5 significant digits");
+		long long needed = 1;
+		for (int d = 0; d < significantDigits; d++)
+			needed *= 10;
+		subBucketBits = 0;
+		while ((1LL << subBucketBits) < needed)
+			subBucketBits++;
+		highest = highestValue;
+		counts.assign(indexOf(highest) + 1, 0);
+	}
+	
+	void add(long long value, long long n = 1){
+		value = std::min(std::max(value, 0LL), highest);
+		counts[indexOf(value)] += n;
+		if (total == 0 || value < minValue)
+			minValue = value;
+		if (value > maxValue)
+			maxValue = value;
+		total += n;
+		sum += value * n;
+	}
+	
+	void add(const TickHistogram& exact){
+		for (long long t = 0; t < exact.range(); t++)
+			if (exact.countOf(t) > 0)
+				add(t, exact.countOf(t));
+	}
+	
+	void merge(const HdrHistogram& other){
+		if (other.subBucketBits != subBucketBits || other.highest != highest)
+			throw invalid_argument("can only merge histograms of the same shape");
+		for (size_t i = 0; i < counts.size(); i++)
+			counts[i] += other.counts[i];
+		if (other.total > 0 && (total == 0 || other.minValue < minValue))
+			minValue = other.minValue;
+		maxValue = std::max(maxValue, other.maxValue);
+		total += other.total;
+		sum += other.sum;
+	}
+	
+	long long count() const {
+		return total;
+	}
+	
+	double mean() const {
+		return total == 0 ? 0 : (double)sum / total;
+	}
+	
+	long long min() const {
+		return minValue;
+	}
+	
+	long long max() const {
+		return maxValue;
+	}
+	
+	// highest value equivalent to the smallest bucket with at least p of the values at or below it, p in [0, 1]
+	long long percentile(double p) const {
+		long long rank = std::max((long long)ceil(p * total), 1LL), seen = 0;
+		for (size_t i = 0; i < counts.size(); i++){
+			seen += counts[i];
+			if (seen >= rank)
+				return std::min(highestAt(i), maxValue);
+		}
+		return maxValue;
+	}
+	
+	// one-line summary: count, mean and the usual percentiles
+	string summary() const {
+		ostringstream out;
+		out << "n=" << total << " mean=" << mean() << " min=" << minValue << " p50=" << percentile(0.5) 
+		    << " p90=" << percentile(0.9) << " p99=" << percentile(0.99) << " p99.9=" << percentile(0.999) 
+		    << " max=" << maxValue;
+		return out.str();
+	}
+};
+
+// one delivered passenger: the ticks the call was assigned, the passenger got in and got out
+struct PassengerRecord {
+	int outFloor;
+	int inFloor;
+	int callTick;
+	int pickupTick;
+	int dropoffTick;
+};
+
+// an elevator with work to do turned around at a floor (its stops are in the PassengerRecords already)
+struct DirectionChange {
+	int tick;
+	int floor;
+	ElevatorDirection to;
+};
+
+/* per-elevator instrumentation: counters, a journey (call to dropoff) histogram, and ring buffers with the
+   latest passengers and direction changes. Everything is allocated when it is enabled, and every elevator
+   has its own, so recording never allocates or shares anything across the parallel stepping. */
+struct ElevatorProbe {
+	long long ticks;             // ticks accounted for so far; busyTicks and loadTicks are accrued lazily
+	                             // whenever the load or the requests change, so idle ticks cost nothing
+	long long busyTicks;         // ticks with someone inside or waiting for the elevator
+	long long loadTicks;         // people inside, summed over ticks
+	long long stops;
+	long long directionChanges;  // while it has someone to pick up or drop off
+	HdrHistogram journeyTicks;
+	RingBuffer<PassengerRecord> passengers;
+	RingBuffer<DirectionChange> turns;
+	
+	ElevatorProbe(size_t ringCapacity = 0, long long highestTick = 1 << 20)
+		: ticks(0), busyTicks(0), loadTicks(0), stops(0), directionChanges(0), 
+		  journeyTicks(highestTick), passengers(ringCapacity), turns(ringCapacity) {}
+	
+	double utilization() const {
+		return ticks == 0 ? 0 : (double)busyTicks / ticks;
+	}
+};
+
+
 class Elevator {
 private:
 	int maxRequests;
@@ -81,16 +433,40 @@ private:
 	int currFloor;
 	ElevatorDirection currMoveDir;
 	
-	/* use a hashmap to track the user requests
-	   key: which floor the users are at --> outside the elevator
-	   value: a hashset for floors users' destinations --> inside the elevator
-	   e.g. {2 : [3, 6, 1]}
-	   several users at floor 2 want to go to floor 3, 6 and 1.  */        
-	unordered_map<int, unordered_set<int>> destRequests; // requested and not processed yet
-	unordered_map<int, unordered_set<int>> destProcess;  // under processing
+	/* track the user requests per floor, one entry per user, with flat per-floor bitsets over them
+	   waiting[2] = {(3, t0), (6, t1), (3, t2)}: users at floor 2 want to go to floor 3, 6 and 3, assigned
+	   at ticks t0, t1, t2; they get in first come first served. destRequests[2] = {3, 6} is the set of
+	   their destinations and pickupFloors has the floors with anyone waiting, so "any request above the
+	   current floor" is a find-first-set. Users under processing are indexed by where they get out:
+	   riders[3] has when and where each of them called and got in, processOrigins[3] = {2, 5} where they got in.  */
+	vector<vector<pair<int, int>>> waiting;   // requested and not processed yet, by outside floor
+	vector<FloorSet> destRequests;
+	FloorSet pickupFloors;
+	int numRequests;
+	struct Rider {
+		int outFloor;
+		int callTick;
+		int pickupTick;
+	};
+	vector<vector<Rider>> riders;             // under processing, by destination floor
+	vector<FloorSet> processOrigins;
+	FloorSet dropoffFloors;
+	
+	// running totals for the simulation metrics
+	long long floorsTravelled;
+	long long pickedUp;
+	long long delivered;
+	long long waitTicks;     // summed over ticks: requests assigned and not picked up yet
+	
+	int currTick;            // number of steps so far
+	bool instrumented;
+	ElevatorProbe probe;     // next to the state step() works on, it is touched on every stop
+	TickHistogram waitHistogram;
+	TickHistogram rideHistogram;
 
 public:
-	Elevator(int max_requests, int max_floor, int min_floor, int cap){
+	// the starting floor and direction are drawn from "seed", so a simulation is reproducible from its seeds alone
+	Elevator(int max_requests, int max_floor, int min_floor, int cap, unsigned seed){
 		maxRequests = max_requests;
 		maxFloor = max_floor;
 		minFloor = min_floor;
@@ -98,10 +474,21 @@ public:
 		numOfPeople = 0;
 		Capacity = cap;
 		
-		currFloor = min_floor + rand() % (max_floor - min_floor);
-				
-		double randNum = (double)rand() / (RAND_MAX + 1.0);
-		currMoveDir = (randNum > 0.5 ? UP : DOWN);
+		mt19937 rng(seed);
+		currFloor = min_floor + rng() % (max_floor - min_floor);
+		currMoveDir = (rng() % 2 ? UP : DOWN);
+		
+		floorsTravelled = pickedUp = delivered = waitTicks = 0;
+		
+		waiting.resize(max_floor + 1);
+		destRequests.assign(max_floor + 1, FloorSet(max_floor));
+		pickupFloors = FloorSet(max_floor);
+		numRequests = 0;
+		riders.resize(max_floor + 1);
+		processOrigins.assign(max_floor + 1, FloorSet(max_floor));
+		dropoffFloors = FloorSet(max_floor);
+		currTick = 0;
+		instrumented = false;
 	}
 	
 	int getCurrFloor(){
@@ -112,11 +499,152 @@ public:
 		return currMoveDir;
 	}
 	
+	int getNumOfPeople(){
+		return numOfPeople;
+	}
+	
+	long long getFloorsTravelled(){
+		return floorsTravelled;
+	}
+	
+	long long getPickedUp(){
+		return pickedUp;
+	}
+	
+	long long getDelivered(){
+		return delivered;
+	}
+	
+	long long getWaitTicks(){
+		return waitTicks;
+	}
+	
+	const TickHistogram& getWaitHistogram(){
+		return waitHistogram;
+	}
+	
+	const TickHistogram& getRideHistogram(){
+		return rideHistogram;
+	}
+	
+	/* append the state step() continues from to a checkpoint: a few ints for the elevator, three per waiting
+	   user (outside floor, destination, call tick) in boarding order, four per rider (destination, origin,
+	   call tick, pickup tick), and the running totals */
+	void save(vector<int>& data, vector<long long>& totals){
+		data.push_back(currFloor);
+		data.push_back(currMoveDir);
+		data.push_back(currTick);
+		data.push_back(numRequests);
+		data.push_back(numOfPeople);
+		for (int out = pickupFloors.next(0); out != -1; out = pickupFloors.next(out + 1)){
+			for (auto& request : waiting[out]){
+				data.push_back(out);
+				data.push_back(request.first);
+				data.push_back(request.second);
+			}
+		}
+		for (int dest = dropoffFloors.next(0); dest != -1; dest = dropoffFloors.next(dest + 1)){
+			for (const Rider& r : riders[dest]){
+				data.push_back(dest);
+				data.push_back(r.outFloor);
+				data.push_back(r.callTick);
+				data.push_back(r.pickupTick);
+			}
+		}
+		totals.push_back(floorsTravelled);
+		totals.push_back(pickedUp);
+		totals.push_back(delivered);
+		totals.push_back(waitTicks);
+	}
+	
+	/* continue from what save() wrote at "data" and "totals", advancing both. Only the floors in use are cleared
+	   and the per-floor lists keep their capacity, so this does not allocate once an elevator has been that busy.
+	   The wait and ride histograms restart empty and instrumentation is turned off: they describe one run. */
+	void restore(const int*& data, const long long*& totals){
+		for (int out = pickupFloors.next(0); out != -1; out = pickupFloors.next(out + 1)){
+			waiting[out].clear();
+			destRequests[out].clear();
+		}
+		pickupFloors.clear();
+		for (int dest = dropoffFloors.next(0); dest != -1; dest = dropoffFloors.next(dest + 1)){
+			riders[dest].clear();
+			processOrigins[dest].clear();
+		}
+		dropoffFloors.clear();
+		
+		currFloor = *data++;
+		currMoveDir = (ElevatorDirection)*data++;
+		currTick = *data++;
+		numRequests = *data++;
+		numOfPeople = *data++;
+		for (int k = 0; k < numRequests; k++, data += 3){
+			waiting[data[0]].push_back(make_pair(data[1], data[2]));
+			destRequests[data[0]].set(data[1]);
+			pickupFloors.set(data[0]);
+		}
+		for (int k = 0; k < numOfPeople; k++, data += 4){
+			riders[data[0]].push_back(Rider{data[1], data[2], data[3]});
+			processOrigins[data[0]].set(data[1]);
+			dropoffFloors.set(data[0]);
+		}
+		floorsTravelled = *totals++;
+		pickedUp = *totals++;
+		delivered = *totals++;
+		waitTicks = *totals++;
+		waitHistogram.clear();
+		rideHistogram.clear();
+		instrumented = false;
+	}
+	
+	// start recording into a fresh probe with rings of "ringCapacity" entries
+	void enableProbe(size_t ringCapacity, long long highestTick){
+		probe = ElevatorProbe(ringCapacity, highestTick);
+		probe.ticks = currTick;
+		instrumented = true;
+	}
+	
+	const ElevatorProbe& getProbe(){
+		if (instrumented)
+			accrueProbe(currTick);
+		return probe;
+	}
+	
+	// count the ticks up to "tick" (exclusive) with the current load and requests
+	void accrueProbe(int tick){
+		long long ticks = tick - probe.ticks;
+		probe.busyTicks += (numOfPeople > 0 || numRequests > 0) * ticks;
+		probe.loadTicks += numOfPeople * ticks;
+		probe.ticks = tick;
+	}
+	
+	/* ticks until the elevator can pick a user up at "floor" who wants to go "dir", following its
+	   current sweep: straight there if it is on the way, otherwise via the furthest floor it still
+	   has requests for in its current direction (and via the other end as well if need be) */
+	int ticksToReach(int floor, ElevatorDirection dir){
+		if (currMoveDir == UP){
+			if (dir == UP && floor >= currFloor)
+				return floor - currFloor;
+			int top = max(currFloor, max(pickupFloors.prev(maxFloor), dropoffFloors.prev(maxFloor)));
+			if (dir == DOWN)
+				return 2 * max(top, floor) - currFloor - floor;
+			int bottom = pickupFloors.next(minFloor), bottomOut = dropoffFloors.next(minFloor);
+			bottom = min(floor, min(bottom == -1 ? floor : bottom, bottomOut == -1 ? floor : bottomOut));
+			return (top - currFloor) + (top - bottom) + (floor - bottom);
+		}
+		else {
+			if (dir == DOWN && floor <= currFloor)
+				return currFloor - floor;
+			int bottom = pickupFloors.next(minFloor), bottomOut = dropoffFloors.next(minFloor);
+			bottom = min(currFloor, min(bottom == -1 ? currFloor : bottom, bottomOut == -1 ? currFloor : bottomOut));
+			if (dir == UP)
+				return currFloor + floor - 2 * min(bottom, floor);
+			int top = max(floor, max(pickupFloors.prev(maxFloor), dropoffFloors.prev(maxFloor)));
+			return (currFloor - bottom) + (top - bottom) + (top - floor);
+		}
+	}
+	
 	int getNumRequests(){
-		int count = 0;
-		for (auto m : destRequests)
-			count += m.second.size();
-		return count;
+		return numRequests;
 	}
 	
 	int isAvailable(){
@@ -124,17 +652,22 @@ public:
 	}
 	
 	bool finish() {
-		return destRequests.empty() && destProcess.empty();
+		return numRequests == 0 && !dropoffFloors.any();
 	}
 	
 	void addNewRequest(int outFloor, int inFloor){
-		destRequests[outFloor].insert(inFloor);
+		if (instrumented)
+			accrueProbe(currTick);
+		waiting[outFloor].push_back(make_pair(inFloor, currTick));
+		destRequests[outFloor].set(inFloor);
+		pickupFloors.set(outFloor);
+		numRequests++;
 	}
 	
 	void printRequests(){
-		for (auto m : destRequests){
-			cout << "outside " << m.first << ": ";
-			for (int n : m.second)
+		for (int out = pickupFloors.next(0); out != -1; out = pickupFloors.next(out + 1)){
+			cout << "outside " << out << ": ";
+			for (int n = destRequests[out].next(0); n != -1; n = destRequests[out].next(n + 1))
 				cout << n << ", ";
 			cout << endl;
 		}
@@ -142,21 +675,30 @@ public:
 	}
 	
 	void printProcess(){
-		for (auto m : destProcess){
-			cout << "outside " << m.first << ": ";
-			for (int n : m.second)
+		for (int out = minFloor; out <= maxFloor; out++){
+			bool any = false;
+			for (int n = dropoffFloors.next(0); n != -1; n = dropoffFloors.next(n + 1)){
+				if (!processOrigins[n].test(out))
+					continue;
+				if (!any)
+					cout << "outside " << out << ": ";
+				any = true;
 				cout << n << ", ";
-			cout << endl;
+			}
+			if (any)
+				cout << endl;
 		}
 		cout << endl;
 	}
 	
 	void moveUp(){
 		currFloor++;
+		floorsTravelled++;
 	}
 	
 	void moveDown() {
 		currFloor--;
+		floorsTravelled++;
 	}
 	
 	void nextDirection(){
@@ -168,33 +710,15 @@ public:
 			// if currMoveDir is UP and there is no requests for upper levels
 			// then change to move DOWN
 			if (currMoveDir == UP){
-				int nextUpperFloor = minFloor;
-				// first check outside requesting floor
-				for (auto m : destRequests)
-					nextUpperFloor = max(nextUpperFloor, m.first);
-				// then check inside requesting destinations
-				for (auto m : destProcess){
-					for (int n : m.second)
-						nextUpperFloor = max(nextUpperFloor, n);
-				}
-					
-				if (nextUpperFloor < currFloor)
+				// check outside requesting floors and inside requesting destinations
+				if (pickupFloors.next(currFloor) == -1 && dropoffFloors.next(currFloor) == -1)
 					currMoveDir = DOWN;
 			}
 			
 			// if currMoveDir is DOWN and there is no requests for lower levels
 			// then change to move UP
 			else {
-				int nextLowerFloor = maxFloor;
-				// first check outside requesting floor
-				for (auto m : destRequests)
-					nextLowerFloor = min(nextLowerFloor, m.first);
-				// then check inside requesting destinations
-				for (auto m : destProcess){
-					for (int n : m.second)
-						nextLowerFloor = min(nextLowerFloor, n);
-				}
-				if (nextLowerFloor > currFloor)
+				if (pickupFloors.prev(currFloor) == -1 && dropoffFloors.prev(currFloor) == -1)
 					currMoveDir = UP;				
 			}
 		}
@@ -202,161 +726,1036 @@ public:
 	
 	
 	void step(){
+		bool stopped = false;
+		
 		// load the outside requests for current floor and let outside people in
 		// should not go beyond elevator capacity
-		if (destRequests.count(currFloor)){
-			while(numOfPeople < Capacity && !destRequests[currFloor].empty()){
-				destProcess[currFloor].insert(*destRequests[currFloor].begin());
-				destRequests[currFloor].erase(destRequests[currFloor].begin());
+		if (instrumented && (pickupFloors.test(currFloor) || !riders[currFloor].empty()))
+			accrueProbe(currTick + 1);   // this tick counts with the load it started with
+		if (pickupFloors.test(currFloor)){
+			vector<pair<int, int>>& queue = waiting[currFloor];
+			size_t boarded = 0;
+			for (; boarded < queue.size() && numOfPeople < Capacity; boarded++){
+				int inFloor = queue[boarded].first;
+				waitHistogram.add(currTick - queue[boarded].second);
+				riders[inFloor].push_back(Rider{currFloor, queue[boarded].second, currTick});
+				processOrigins[inFloor].set(currFloor);
+				dropoffFloors.set(inFloor);
 				numOfPeople++;
+				pickedUp++;
 			}
-			if (destRequests[currFloor].empty())
-				destRequests.erase(currFloor);
+			queue.erase(queue.begin(), queue.begin() + boarded);
+			numRequests -= boarded;
+			stopped = (boarded > 0);
+			destRequests[currFloor].clear();
+			for (auto& request : queue)
+				destRequests[currFloor].set(request.first);
+			if (queue.empty())
+				pickupFloors.reset(currFloor);
 		}
+		waitTicks += numRequests;
 		
 		// process inside requests targeting currFloor and let inside person out
-		vector<int> emptyIdx;
-		for (auto& request : destProcess){
-			if (request.second.count(currFloor)){
-				request.second.erase(currFloor);
-				numOfPeople--;
-				if (request.second.empty())
-					emptyIdx.push_back(request.first);
+		if (!riders[currFloor].empty()){
+			for (const Rider& r : riders[currFloor]){
+				rideHistogram.add(currTick - r.pickupTick);
+				if (instrumented){
+					probe.journeyTicks.add(currTick - r.callTick);
+					probe.passengers.push(PassengerRecord{r.outFloor, currFloor, r.callTick, r.pickupTick, currTick});
+				}
 			}
+			numOfPeople -= riders[currFloor].size();
+			delivered += riders[currFloor].size();
+			riders[currFloor].clear();
+			processOrigins[currFloor].clear();
+			dropoffFloors.reset(currFloor);
+			stopped = true;
 		}
-		for (int idx : emptyIdx)
-			destProcess.erase(idx);
 		
 		// decide which direction for next move
+		ElevatorDirection lastDir = currMoveDir;
 		nextDirection();
+		if (instrumented){
+			if (stopped)
+				probe.stops++;
+			// an idle elevator turns around every tick, that is not counted
+			if (currMoveDir != lastDir && (numOfPeople > 0 || numRequests > 0)){
+				probe.directionChanges++;
+				probe.turns.push(DirectionChange{currTick, currFloor, currMoveDir});
+			}
+		}
 		
 		// move next
 		if (currMoveDir == UP)
 			moveUp();
 		else
 			moveDown();
+		currTick++;
 	}
 };
 
 
-class Controller {
-private:
+// what a (headless) simulation run reports instead of printing every tick
+struct SimulationMetrics {
+	long long ticks;
+	long long floorsTravelled;
+	long long passengersPickedUp;
+	long long passengersDelivered;
+	long long waitTicks;     // ticks users spent waiting to be picked up, summed over users
+	double wallSeconds;
+};
+
+// solver latency of the batch assignment mode
+struct BatchStats {
+	long long batches;
+	long long requests;
+	long long greedyFallbacks;   // requests the solver did not get to within the latency budget
+	long long unassigned;
+	double totalSeconds;
+	double maxSeconds;
+};
+
+
+/* minimum-cost assignment of "rows" requests to "cols" >= rows slots (Hungarian algorithm with
+   potentials, O(rows^2 * cols)). cost is rows x cols, row-major. Rows are added one at a time, each
+   keeping the assignment optimal for the rows so far; once "deadline" has passed no more rows are
+   added and the remaining ones come back as -1. */
+vector<int> minCostAssignment(const vector<long long>& cost, int rows, int cols, 
+                              bool useDeadline, chrono::steady_clock::time_point deadline){
+	const long long INF = LLONG_MAX / 4;
+	vector<long long> u(rows + 1, 0), v(cols + 1, 0), minv(cols + 1);
+	vector<int> match(cols + 1, 0), way(cols + 1, 0);   // match[col] = row, 1-based, 0 = free
+	vector<char> used(cols + 1);
+	for (int i = 1; i <= rows; i++){
+		if (useDeadline && chrono::steady_clock::now() > deadline)
+			break;
+		match[0] = i;
+		int j0 = 0;
+		fill(minv.begin(), minv.end(), INF);
+		fill(used.begin(), used.end(), 0);
+		do {
+			used[j0] = 1;
+			int i0 = match[j0], j1 = 0;
+			long long delta = INF;
+			const long long* row = &cost[(size_t)(i0 - 1) * cols];
+			for (int j = 1; j <= cols; j++){
+				if (used[j])
+					continue;
+				long long cur = row[j - 1] - u[i0] - v[j];
+				if (cur < minv[j]){
+					minv[j] = cur;
+					way[j] = j0;
+				}
+				if (minv[j] < delta){
+					delta = minv[j];
+					j1 = j;
+				}
+			}
+			for (int j = 0; j <= cols; j++){
+				if (used[j]){
+					u[match[j]] += delta;
+					v[j] -= delta;
+				}
+				else
+					minv[j] -= delta;
+			}
+			j0 = j1;
+		} while (match[j0] != 0);
+		do {
+			int j1 = way[j0];
+			match[j0] = match[j1];
+			j0 = j1;
+		} while (j0 != 0);
+	}
+	vector<int> colOfRow(rows, -1);
+	for (int j = 1; j <= cols; j++)
+		if (match[j] != 0)
+			colOfRow[match[j] - 1] = j - 1;
+	return colOfRow;
+}
+
+
+/* the state of a Controller and its elevators at one tick, flattened by Elevator::save(). Taking one and
+   restoring it are linear in the number of elevators and users in the system, and reusing a checkpoint and a
+   branch Controller does not allocate, so a simulation can be forked many times per decision. */
+struct SimulationCheckpoint {
 	int numOfElevators;
 	int numOfFloors;
 	int maxElevatorRequests;
 	int elevatorCapacity;
+	long long tick;
+	vector<int> data;
+	vector<long long> totals;
 	
-	vector<Elevator*> elevators;
-	vector<pair<int, int>> requests;
-	
-public:
-	Controller(int num_elevators, int num_floors, int max_elevator_requests, int elevator_cap){
-		numOfElevators = num_elevators;
-		numOfFloors = num_floors;
-		maxElevatorRequests = max_elevator_requests;
-		elevatorCapacity = elevator_cap;
-		
-		for (int i = 0; i < numOfElevators; i++)
-			elevators.push_back(new Elevator(maxElevatorRequests, numOfFloors, 1, elevatorCapacity));
+	size_t bytes() const {
+		return sizeof(SimulationCheckpoint) + data.size() * sizeof(int) + totals.size() * sizeof(long long);
 	}
+};
+
+
+// one record of the binary trace file: the state of one elevator at one sampled tick
+struct TraceRecord {
+	int tick;
+	int elevator;
+	int floor;
+	int direction;
+	int numOfPeople;
+	int numRequests;
+};
+
+
+// a request of a streamed trace: at "tick" a user at outFloor wants to go to inFloor
+struct RequestRecord {
+	int tick;
+	int outFloor;
+	int inFloor;
+};
+
+// requests in tick order, read one at a time so the whole trace never has to be in memory
+class RequestSource {
+public:
+	virtual ~RequestSource() {}
+	virtual bool next(RequestRecord& request) = 0;
+};
+
+// a source over any iterator range of RequestRecords
+template<class It>
+class RangeRequestSource : public RequestSource {
+private:
+	It curr, end;
 	
-	~Controller(){
-		for (int i = 0; i < numOfElevators; i++)
-			delete elevators[i];
-		cout << "cleared the controller!" << endl;
-	}
+public:
+	RangeRequestSource(It begin, It end) : curr(begin), end(end) {}
 	
-	void loadRequests(vector<pair<int, int>>& req){
-		for (auto r : req)
-			requests.push_back(r);
+	bool next(RequestRecord& request){
+		if (curr == end)
+			return false;
+		request = *curr++;
+		return true;
 	}
+};
+
+/* a binary trace file of packed RequestRecords, memory-mapped and read front to back. Pages already
+   read are given back to the kernel every 64 MiB, so a long trace does not stay resident. */
+class MappedRequestTrace : public RequestSource {
+private:
+	int fd;
+	char* data;
+	size_t length;
+	size_t offset;
+	size_t released;   // bytes before this offset were handed back with MADV_DONTNEED
 	
-	
-	/* the strategy to assign a request to an elevator
-	1. find all the elevators currently moveing up (uplist) and down (downlist)
-	2. If the user wants to go to upper level floor
-		a. iterate through uplist, find the closest available elevator BELOW the outFloor 
-		b. if not possible, iterate through downlist, find the closest available elevator
-		c. if still not possible, iterate through the whole elevator list and find the first available one
-		d. if still still not possible, return error.
-	3. If the user wants to go to lower level floor, follow similar process */	
-	void assignRequests(){
-		vector<int> upList, downList;
-		for (int i = 0; i < numOfElevators; i++){
-			if (elevators[i]->getCurrMoveDir() == UP)
-				upList.push_back(i);
-			else
-				downList.push_back(i);
+public:
+	MappedRequestTrace(const string& path){
+		fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw runtime_error("cannot open request trace " + path);
+		struct stat info;
+		if (fstat(fd, &info) != 0){
+			close(fd);
+			throw runtime_error("cannot stat request trace " + path);
 		}
-		
-		for (auto r : requests){
-			int outFloor = r.first, inFloor = r.second;
-			bool success = assignUserRequest(upList, downList, outFloor, inFloor);
-			if (!success){
-				cout << "unable to assign request (outFloor: " << outFloor << ", inFloor: " << inFloor << ")" << endl;
-				return;
+		length = info.st_size;
+		offset = released = 0;
+		data = NULL;
+		if (length > 0){
+			void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped == MAP_FAILED){
+				close(fd);
+				throw runtime_error("cannot map request trace " + path);
 			}
+			data = (char*)mapped;
+			madvise(data, length, MADV_SEQUENTIAL);
 		}
-		cout << "assign request successful" << endl;
-		printRequestsAssignment();
-		cout << "-------------------------" << endl;
 	}
 	
+	// owns the descriptor and the mapping, a copy would release them twice
+	MappedRequestTrace(const MappedRequestTrace&) = delete;
+	MappedRequestTrace& operator=(const MappedRequestTrace&) = delete;
 	
-	bool assignUserRequest(vector<int>& upList, vector<int>& downList, int outFloor, int inFloor){
-		bool UserWantsUp = (outFloor < inFloor);
-		int minDist = INT_MAX, minDistIdx = -1;
-		if (UserWantsUp){
-			// wants to go up, try to assign to some elevator in uplist
-			for (int up : upList){
-				if (elevators[up]->getCurrFloor() < outFloor &&
-					elevators[up]->isAvailable() &&
-				    outFloor - elevators[up]->getCurrFloor() < minDist){
-				    minDist = outFloor - elevators[up]->getCurrFloor();
-				    minDistIdx = up;
-				}
-			}			
-		} 
-		else {
-			// wants to go down, try to assign to some elevator in downlist
-			for (int down : downList){
-				if (elevators[down]->getCurrFloor() > outFloor &&
-					elevators[down]->isAvailable() &&
-				    elevators[down]->getCurrFloor() - outFloor < minDist){
-				    minDist = elevators[down]->getCurrFloor() - outFloor;
-				    minDistIdx = down;
-				}
-			}			
-		}
-		if (minDistIdx != -1){
-			elevators[minDistIdx]->addNewRequest(outFloor, inFloor);
-			return true;
+	~MappedRequestTrace(){
+		if (data != NULL)
+			munmap(data, length);
+		close(fd);
+	}
+	
+	bool next(RequestRecord& request){
+		if (offset + sizeof(RequestRecord) > length)
+			return false;
+		memcpy(&request, data + offset, sizeof(RequestRecord));
+		offset += sizeof(RequestRecord);
+		const size_t chunk = 64 << 20;
+		if (offset - released >= 2 * chunk){
+			madvise(data + released, chunk, MADV_DONTNEED);
+			released += chunk;
 		}
-		
-		//if not successful, try the other moving direction, find the closest
-		vector<int>& secondPrimaryList = (UserWantsUp ? downList : upList);
-		for (int idx : secondPrimaryList){
-			if (elevators[idx]->isAvailable() && 
-			    abs(elevators[idx]->getCurrFloor() - outFloor) < minDist){
-				minDist = abs(elevators[idx]->getCurrFloor() - outFloor);
-				minDistIdx = idx;
+		return true;
+	}
+};
+
+// writes every request of "source" to a trace file that MappedRequestTrace can read back, and throws
+// rather than leave a truncated trace behind (a full disk would otherwise replay as a shorter day)
+void writeRequestTrace(const string& path, RequestSource& source){
+	FILE* f = fopen(path.c_str(), "wb");
+	if (f == NULL)
+		throw runtime_error("cannot create request trace " + path);
+	vector<RequestRecord> buffer;
+	RequestRecord request;
+	bool more = true;
+	while (more){
+		more = source.next(request);
+		if (more)
+			buffer.push_back(request);
+		if (buffer.size() == 4096 || (!more && !buffer.empty())){
+			if (fwrite(buffer.data(), sizeof(RequestRecord), buffer.size(), f) != buffer.size()){
+				fclose(f);
+				throw runtime_error("cannot write request trace " + path);
 			}
+			buffer.clear();
 		}
-		if (minDistIdx != -1){
-			elevators[minDistIdx]->addNewRequest(outFloor, inFloor);
-			return true;
+	}
+	if (fclose(f) != 0)
+		throw runtime_error("cannot write request trace " + path);
+}
+
+// "count" uniformly random requests, "perTick" of them arriving every tick on average, generated on the fly
+class GeneratedRequestSource : public RequestSource {
+private:
+	long long remaining;
+	int numFloors;
+	double tick;
+	mt19937 rng;
+	exponential_distribution<double> gap;
+	
+public:
+	GeneratedRequestSource(long long count, int num_floors, double perTick, unsigned seed)
+		: remaining(count), numFloors(num_floors), tick(0), rng(seed), gap(perTick) {}
+	
+	bool next(RequestRecord& request){
+		if (remaining-- <= 0)
+			return false;
+		tick += gap(rng);
+		int outFloor = 1 + rng() % numFloors;
+		int inFloor = 1 + rng() % (numFloors - 1);
+		if (inFloor >= outFloor)
+			inFloor++;
+		request = RequestRecord{(int)tick, outFloor, inFloor};
+		return true;
+	}
+};
+
+
+/* a fixed set of threads that run one job split into size() parts and wait for all of them.
+   Part 0 runs on the calling thread. Used once per tick, so the threads are kept instead of spawned. */
+class WorkerPool {
+private:
+	int numParts;
+	vector<thread> workers;
+	mutex lock;
+	condition_variable startCond, doneCond;
+	long long generation;     // bumped for every job
+	int pending;              // parts of the current job not done yet
+	bool stopping;
+	function<void(int)> job;
+	
+	void workerLoop(int part){
+		long long seen = 0;
+		while (true){
+			{
+				unique_lock<mutex> guard(lock);
+				startCond.wait(guard, [&]{ return stopping || generation != seen; });
+				if (stopping)
+					return;
+				seen = generation;
+			}
+			job(part);
+			lock_guard<mutex> guard(lock);
+			if (--pending == 0)
+				doneCond.notify_one();
+		}
+	}
+	
+public:
+	WorkerPool(int num_threads){
+		if (num_threads <= 0)
+			throw invalid_argument("need at least one thread");
+		numParts = num_threads;
+		generation = 0;
+		pending = 0;
+		stopping = false;
+		for (int part = 1; part < numParts; part++)
+			workers.push_back(thread(&WorkerPool::workerLoop, this, part));
+	}
+	
+	~WorkerPool(){
+		{
+			lock_guard<mutex> guard(lock);
+			stopping = true;
+		}
+		startCond.notify_all();
+		for (thread& t : workers)
+			t.join();
+	}
+	
+	int size(){
+		return numParts;
+	}
+	
+	void runParts(const function<void(int)>& f){
+		{
+			lock_guard<mutex> guard(lock);
+			job = f;
+			pending = numParts - 1;
+			generation++;
+		}
+		startCond.notify_all();
+		f(0);
+		unique_lock<mutex> guard(lock);
+		doneCond.wait(guard, [&]{ return pending == 0; });
+	}
+};
+
+
+/* the dispatch state of all elevators as contiguous arrays (structure of arrays) padded to whole blocks of
+   LANES cars, so filtering the candidates for a request is a few SIMD compares per block of cars instead of
+   a pointer chase and getter calls per car. Floor and index are packed into one 32-bit key per car, so
+   "highest floor below, lowest index on ties" is a single max reduction over the candidates' keys. */
+class ElevatorBank {
+public:
+	static const int LANES = 4;   // 128-bit blocks, available on any x86-64 (SSE2) or ARM (NEON)
+	typedef int Block __attribute__((vector_size(LANES * sizeof(int))));
+	
+private:
+	int numCars;
+	int maxRequests;
+	vector<int> floors;
+	vector<int> loads;
+	vector<int> pending;
+	vector<int> belowKeys;       // floor << 16 | (0xFFFF - index): the max is the highest floor, then the lowest index
+	vector<int> aboveKeys;       // floor << 16 | index: the min is the lowest floor, then the lowest index
+	vector<int> availableUp;     // -1 if the car takes requests and moves up, else 0; padding cars are never available
+	vector<int> availableDown;
+	
+	static Block splat(int x){
+		Block b;
+		for (int k = 0; k < LANES; k++)
+			b[k] = x;
+		return b;
+	}
+	
+	static Block load(const vector<int>& v, size_t i){
+		Block b;
+		memcpy(&b, &v[i], sizeof(Block));
+		return b;
+	}
+	
+	// select by compare masks, SSE2 has no 32-bit min/max
+	static Block maxOf(Block a, Block b){
+		Block m = a > b;
+		return (a & m) | (b & ~m);
+	}
+	
+	static Block minOf(Block a, Block b){
+		Block m = a < b;
+		return (a & m) | (b & ~m);
+	}
+	
+public:
+	ElevatorBank() : numCars(0), maxRequests(0) {}
+	
+	ElevatorBank(int num_cars, int maxFloor, int max_requests){
+		if (num_cars > 0x10000 || maxFloor >= 0x8000)
+			throw invalid_argument("the elevator bank packs up to 65536 cars and floors below 32768 into 32-bit keys");
+		numCars = num_cars;
+		maxRequests = max_requests;
+		size_t padded = (num_cars + LANES - 1) / LANES * LANES;
+		floors.assign(padded, 0);
+		loads.assign(padded, 0);
+		pending.assign(padded, 0);
+		belowKeys.assign(padded, 0);
+		aboveKeys.assign(padded, 0);
+		availableUp.assign(padded, 0);
+		availableDown.assign(padded, 0);
+	}
+	
+	void update(int car, int floor, ElevatorDirection dir, int load, int requests){
+		floors[car] = floor;
+		loads[car] = load;
+		pending[car] = requests;
+		belowKeys[car] = floor << 16 | (0xFFFF - car);
+		aboveKeys[car] = floor << 16 | car;
+		availableUp[car] = (dir == UP && requests < maxRequests ? -1 : 0);
+		availableDown[car] = (dir == DOWN && requests < maxRequests ? -1 : 0);
+	}
+	
+	void addRequest(int car){
+		if (++pending[car] >= maxRequests)
+			availableUp[car] = availableDown[car] = 0;
+	}
+	
+	int floorOf(int car) const {
+		return floors[car];
+	}
+	
+	bool isAvailable(int car) const {
+		return availableUp[car] | availableDown[car];
+	}
+	
+	// nobody waiting for or riding in any car
+	bool allFinished() const {
+		Block busy = splat(0);
+		for (size_t i = 0; i < floors.size(); i += LANES)
+			busy |= load(pending, i) | load(loads, i);
+		for (int k = 0; k < LANES; k++)
+			if (busy[k])
+				return false;
+		return true;
+	}
+	
+	// lowest-index available car moving "dir" at the highest floor below "floor", or -1
+	int nearestBelow(ElevatorDirection dir, int floor) const {
+		const vector<int>& available = (dir == UP ? availableUp : availableDown);
+		Block limit = splat(floor), best = splat(-1);
+		for (size_t i = 0; i < floors.size(); i += LANES){
+			Block m = load(available, i) & (load(floors, i) < limit);
+			best = maxOf(best, (load(belowKeys, i) & m) | ~m);
+		}
+		int key = -1;
+		for (int k = 0; k < LANES; k++)
+			key = max(key, best[k]);
+		return key == -1 ? -1 : 0xFFFF - (key & 0xFFFF);
+	}
+	
+	// lowest-index available car moving "dir" at the lowest floor at or above "floor", or -1
+	int nearestAtOrAbove(ElevatorDirection dir, int floor) const {
+		const vector<int>& available = (dir == UP ? availableUp : availableDown);
+		Block limit = splat(floor), none = splat(INT_MAX), best = none;
+		for (size_t i = 0; i < floors.size(); i += LANES){
+			Block m = load(available, i) & ~(load(floors, i) < limit);
+			best = minOf(best, (load(aboveKeys, i) & m) | (none & ~m));
+		}
+		int key = INT_MAX;
+		for (int k = 0; k < LANES; k++)
+			key = min(key, best[k]);
+		return key == INT_MAX ? -1 : key & 0xFFFF;
+	}
+	
+	int firstAvailable() const {
+		for (int i = 0; i < numCars; i++)
+			if (availableUp[i] | availableDown[i])
+				return i;
+		return -1;
+	}
+};
+
+
+class Controller;
+class EventSimulation;
+struct TimedRequest;
+
+/* decides which elevator serves a new request. Controller asks chooseElevator() once per request it
+   assigns and EventSimulation asks chooseCar() once per arrival, with the engine's current state, so both
+   have to be cheap: the policies in this file are a single pass over the cars or a few index lookups.
+   A policy implements the engines it makes sense for, the other one throws. */
+class DispatchPolicy {
+public:
+	virtual ~DispatchPolicy() {}
+	virtual string name() = 0;
+	
+	// an elevator that is available for the request, or -1 if none can take it now (it is retried later)
+	virtual int chooseElevator(Controller&, int, int){
+		throw invalid_argument(name() + " does not dispatch for Controller");
+	}
+	
+	// the car for the call, there is no retrying in the event engine
+	virtual int chooseCar(const EventSimulation&, const TimedRequest&){
+		throw invalid_argument(name() + " does not dispatch for EventSimulation");
+	}
+};
+
+/* Controller's default: the nearest available elevator already moving the caller's way from the right side
+   (below the caller going up, above going down), otherwise the nearest available one moving the other way,
+   otherwise the first available one. Ties go to the lower index. */
+class NearestCarPolicy : public DispatchPolicy {
+public:
+	string name() { return "nearest car"; }
+	int chooseElevator(Controller& controller, int outFloor, int inFloor);
+	int chooseCar(const EventSimulation& sim, const TimedRequest& req);
+};
+
+
+class Controller {
+private:
+	int numOfElevators;
+	int numOfFloors;
+	int maxElevatorRequests;
+	int elevatorCapacity;
+	
+	vector<Elevator*> elevators;
+	vector<pair<int, int>> requests;
+	
+	/* the elevators' floor, direction, load and requests, mirrored into contiguous arrays on every step and
+	   assignment, for allFinish() and for dispatching with SIMD scans */
+	ElevatorBank bank;
+	
+	/* available elevators ordered by (floor, index), one set per moving direction, so the nearest one
+	   below/above a floor is a lower_bound. Building them costs about as much as SCANS_BEFORE_INDEX scans of
+	   the bank, so after the elevators move the first requests are dispatched by scans and the sets are only
+	   built once more requests than that come in before the next move, or right away if the last tick needed
+	   them too. An elevator is erased once it stops being available. Both ways make the same choices. */
+	set<pair<int, int>> availableUp, availableDown;
+	set<int> availableAll;
+	bool indexFresh;
+	bool indexLastTick;
+	int scansSinceMove;
+	static const int SCANS_BEFORE_INDEX = 64;
+	
+	BatchStats batchStats;
+	double solverNsPerUnit;   // measured solver time per rows^2 * cols, to size batches under a latency budget
+	
+	WorkerPool* pool;    // steps the elevators of a tick in parallel, NULL for serial
+	
+	NearestCarPolicy defaultPolicy;
+	DispatchPolicy* policy;
+	
+	long long streamedRequests;
+	long long peakBacklog;
+	long long instrumentHighestTick;
+	
+	bool verbose;        // print the state on every tick, turned off for headless simulation
+	long long currTick;
+	double wallSeconds;
+	FILE* traceFile;     // sampled binary trace, NULL when tracing is off
+	int traceEvery;
+	
+	void writeTrace(){
+		vector<TraceRecord> records;
+		for (int i = 0; i < numOfElevators; i++){
+			records.push_back(TraceRecord{(int)currTick, i, elevators[i]->getCurrFloor(), elevators[i]->getCurrMoveDir(),
+			                              elevators[i]->getNumOfPeople(), elevators[i]->getNumRequests()});
 		}
+		fwrite(records.data(), sizeof(TraceRecord), records.size(), traceFile);
+	}
+	
+public:
+	// the elevators' starting states are drawn from "seed"
+	Controller(int num_elevators, int num_floors, int max_elevator_requests, int elevator_cap, bool verbose = true,
+	           unsigned seed = 1){
+		// an elevator that can never take a request would leave runStream's backlog waiting forever
+		if (num_elevators < 1 || num_floors < 2 || max_elevator_requests < 1 || elevator_cap < 1)
+			throw invalid_argument("need an elevator, two floors, and room for a request and a passenger");
+		numOfElevators = num_elevators;
+		numOfFloors = num_floors;
+		maxElevatorRequests = max_elevator_requests;
+		elevatorCapacity = elevator_cap;
+		
+		this->verbose = verbose;
+		currTick = 0;
+		wallSeconds = 0;
+		traceFile = NULL;
+		traceEvery = 0;
+		pool = NULL;
+		streamedRequests = peakBacklog = 0;
+		instrumentHighestTick = 1 << 20;
+		batchStats = BatchStats{0, 0, 0, 0, 0, 0};
+		solverNsPerUnit = 1.0;
+		indexFresh = indexLastTick = false;
+		scansSinceMove = 0;
+		policy = &defaultPolicy;
 		
-		//if still not successful, try iterate through all elevator and find the first available
+		bank = ElevatorBank(numOfElevators, numOfFloors, maxElevatorRequests);
+		mt19937 rng(seed);
 		for (int i = 0; i < numOfElevators; i++){
-			if (elevators[i]->isAvailable()){
-				elevators[i]->addNewRequest(outFloor, inFloor);
-				return true;
+			elevators.push_back(new Elevator(maxElevatorRequests, numOfFloors, 1, elevatorCapacity, rng()));
+			syncBank(i);
+		}
+	}
+	
+	// a new branch continuing from "checkpoint"
+	Controller(const SimulationCheckpoint& checkpoint, bool verbose = false)
+		: Controller(checkpoint.numOfElevators, checkpoint.numOfFloors, checkpoint.maxElevatorRequests, 
+		             checkpoint.elevatorCapacity, verbose) {
+		restore(checkpoint);
+	}
+	
+	~Controller(){
+		for (int i = 0; i < numOfElevators; i++)
+			delete elevators[i];
+		delete pool;
+		if (traceFile != NULL)
+			fclose(traceFile);
+		if (verbose)
+			cout << "cleared the controller!" << endl;
+	}
+	
+	// "dispatch" places every request from now on, it is not owned; NULL goes back to NearestCarPolicy
+	void setDispatchPolicy(DispatchPolicy* dispatch){
+		policy = (dispatch != NULL ? dispatch : &defaultPolicy);
+	}
+	
+	/* step the elevators of each tick on numThreads threads (1 = serial). Every elevator only touches its own
+	   state in step(), the elevators are split into fixed contiguous ranges, and everything that looks across
+	   elevators (metrics, trace, assignment) happens between ticks in index order, so the results are
+	   identical to the serial run. The printing mode always runs serially. */
+	void setNumThreads(int numThreads){
+		if (numThreads <= 0)
+			throw invalid_argument("need at least one thread");
+		delete pool;
+		pool = (numThreads > 1 ? new WorkerPool(numThreads) : NULL);
+	}
+	
+	// write every elevator's state as TraceRecords to "path" on every "sampleEvery"-th tick
+	void enableTrace(const string& path, int sampleEvery){
+		if (sampleEvery <= 0)
+			throw invalid_argument("trace sampling interval must be positive");
+		if (traceFile != NULL)
+			fclose(traceFile);
+		traceFile = fopen(path.c_str(), "wb");
+		if (traceFile == NULL)
+			throw runtime_error("cannot open trace file " + path);
+		traceEvery = sampleEvery;
+	}
+	
+	SimulationMetrics getMetrics(){
+		SimulationMetrics metrics{currTick, 0, 0, 0, 0, wallSeconds};
+		for (int i = 0; i < numOfElevators; i++){
+			metrics.waitTicks += elevators[i]->getWaitTicks();
+			metrics.floorsTravelled += elevators[i]->getFloorsTravelled();
+			metrics.passengersPickedUp += elevators[i]->getPickedUp();
+			metrics.passengersDelivered += elevators[i]->getDelivered();
+		}
+		return metrics;
+	}
+	
+	const Elevator& getElevator(int elevator){
+		if (elevator < 0 || elevator >= numOfElevators)
+			throw invalid_argument("no such elevator");
+		return *elevators[elevator];
+	}
+	
+	bool isElevatorAvailable(int elevator){
+		return bank.isAvailable(elevator);
+	}
+	
+	int getElevatorFloor(int elevator){
+		return bank.floorOf(elevator);
+	}
+	
+	int getElevatorRequests(int elevator){
+		return elevators[elevator]->getNumRequests();
+	}
+	
+	int ticksToReach(int elevator, int floor, ElevatorDirection dir){
+		return elevators[elevator]->ticksToReach(floor, dir);
+	}
+	
+	int getNumElevators(){
+		return numOfElevators;
+	}
+	
+	int getNumFloors(){
+		return numOfFloors;
+	}
+	
+	BatchStats getBatchStats(){
+		return batchStats;
+	}
+	
+	// ticks from assignment to pickup and from pickup to dropoff, over all elevators
+	TickHistogram getWaitHistogram(){
+		TickHistogram all;
+		for (int i = 0; i < numOfElevators; i++)
+			all.merge(elevators[i]->getWaitHistogram());
+		return all;
+	}
+	
+	TickHistogram getRideHistogram(){
+		TickHistogram all;
+		for (int i = 0; i < numOfElevators; i++)
+			all.merge(elevators[i]->getRideHistogram());
+		return all;
+	}
+	
+	/* record per-passenger call/pickup/dropoff ticks and per-elevator utilization, stops and direction
+	   changes from now on. Each elevator keeps the latest "ringCapacity" passengers and turns; the counters
+	   and histograms (up to "highestTick") cover the whole run. */
+	void enableInstrumentation(size_t ringCapacity = 1024, long long highestTick = 1 << 20){
+		if (ringCapacity == 0 || highestTick < 1)
+			throw invalid_argument("instrumentation needs ring buffers and a tick range");
+		for (int i = 0; i < numOfElevators; i++)
+			elevators[i]->enableProbe(ringCapacity, highestTick);
+		instrumentHighestTick = highestTick;
+	}
+	
+	const ElevatorProbe& getProbe(int elevator){
+		if (elevator < 0 || elevator >= numOfElevators)
+			throw invalid_argument("no such elevator");
+		return elevators[elevator]->getProbe();
+	}
+	
+	/* call to pickup and call to dropoff, over all elevators. The wait times are the exact ones every elevator
+	   keeps anyway, over the whole run, bucketed on export rather than recorded twice. */
+	HdrHistogram getWaitHdr(){
+		HdrHistogram all(instrumentHighestTick);
+		for (int i = 0; i < numOfElevators; i++)
+			all.add(elevators[i]->getWaitHistogram());
+		return all;
+	}
+	
+	HdrHistogram getJourneyHdr(){
+		HdrHistogram all(instrumentHighestTick);
+		for (int i = 0; i < numOfElevators; i++)
+			all.merge(elevators[i]->getProbe().journeyTicks);
+		return all;
+	}
+	
+	void printInstrumentation(ostream& out){
+		out << "wait:    " << getWaitHdr().summary() << endl;
+		out << "journey: " << getJourneyHdr().summary() << endl;
+		for (int i = 0; i < numOfElevators; i++){
+			const ElevatorProbe& p = elevators[i]->getProbe();
+			out << "elevator " << i << ": utilization " << p.utilization() << ", mean load " 
+			    << (p.ticks == 0 ? 0 : (double)p.loadTicks / p.ticks) << ", " << p.stops << " stops, " 
+			    << p.directionChanges << " direction changes" << endl;
+		}
+	}
+	
+	// the passengers still held in the ring buffers, one CSV row each
+	void writePassengerLog(ostream& out){
+		out << "elevator,out_floor,in_floor,call_tick,pickup_tick,dropoff_tick\n";
+		for (int i = 0; i < numOfElevators; i++){
+			const RingBuffer<PassengerRecord>& log = elevators[i]->getProbe().passengers;
+			for (size_t k = 0; k < log.size(); k++)
+				out << i << ',' << log[k].outFloor << ',' << log[k].inFloor << ',' << log[k].callTick << ',' 
+				    << log[k].pickupTick << ',' << log[k].dropoffTick << '\n';
+		}
+	}
+	
+	/* snapshot the elevators between ticks into "checkpoint", reusing its buffers. Loaded requests, the latency
+	   and streaming statistics, the trace file and the thread pool are not part of it. */
+	void checkpoint(SimulationCheckpoint& checkpoint){
+		checkpoint.numOfElevators = numOfElevators;
+		checkpoint.numOfFloors = numOfFloors;
+		checkpoint.maxElevatorRequests = maxElevatorRequests;
+		checkpoint.elevatorCapacity = elevatorCapacity;
+		checkpoint.tick = currTick;
+		checkpoint.data.clear();
+		checkpoint.totals.clear();
+		for (int i = 0; i < numOfElevators; i++)
+			elevators[i]->save(checkpoint.data, checkpoint.totals);
+	}
+	
+	// can restore() take "checkpoint"?
+	bool sameShape(const SimulationCheckpoint& checkpoint){
+		return checkpoint.numOfElevators == numOfElevators && checkpoint.numOfFloors == numOfFloors && 
+		       checkpoint.maxElevatorRequests == maxElevatorRequests && checkpoint.elevatorCapacity == elevatorCapacity;
+	}
+	
+	// continue from "checkpoint", taken from a controller of the same shape (this one or another)
+	void restore(const SimulationCheckpoint& checkpoint){
+		if (!sameShape(checkpoint))
+			throw invalid_argument("checkpoint is from a controller of a different shape");
+		const int* data = checkpoint.data.data();
+		const long long* totals = checkpoint.totals.data();
+		for (int i = 0; i < numOfElevators; i++){
+			elevators[i]->restore(data, totals);
+			syncBank(i);
+		}
+		currTick = checkpoint.tick;
+		indexFresh = indexLastTick = false;
+		scansSinceMove = 0;
+	}
+	
+	void loadRequests(vector<pair<int, int>>& req){
+		for (auto r : req)
+			requests.push_back(r);
+	}
+	
+	
+	/* the strategy to assign a request to an elevator (NearestCarPolicy, unless setDispatchPolicy() says otherwise)
+	1. find all the elevators currently moveing up (uplist) and down (downlist)
+	2. If the user wants to go to upper level floor
+		a. iterate through uplist, find the closest available elevator BELOW the outFloor 
+		b. if not possible, iterate through downlist, find the closest available elevator
+		c. if still not possible, iterate through the whole elevator list and find the first available one
+		d. if still still not possible, return error.
+	3. If the user wants to go to lower level floor, follow similar process */	
+	bool assignRequests(){
+		for (auto r : requests){
+			int outFloor = r.first, inFloor = r.second;
+			bool success = assignUserRequest(outFloor, inFloor);
+			if (!success){
+				if (verbose)
+					cout << "unable to assign request (outFloor: " << outFloor << ", inFloor: " << inFloor << ")" << endl;
+				return false;
 			}
 		}
-		
-		//assign failure
-		return false;				
+		if (verbose){
+			cout << "assign request successful" << endl;
+			printRequestsAssignment();
+			cout << "-------------------------" << endl;
+		}
+		return true;
+	}
+	
+	
+	/* batch mode: take the requests "window" at a time and give each window a minimum-cost assignment
+	   instead of placing one request after the other. An elevator with k free request slots (maxRequests
+	   minus what it has) contributes k columns; the j-th of them costs ticksToReach + (numRequests + j),
+	   so a request taken by a busier elevator pays for the queue in front of it.
+	   With a latency budget (budgetMicros > 0) only as many requests of a window as the solver is expected
+	   to place within the budget go into the matrix, and whatever it has not placed when the budget runs
+	   out is assigned greedily. Requests that fit nowhere are skipped, not fatal, and make this return false. */
+	bool assignRequestsBatch(int window, double budgetMicros = 0){
+		if (window <= 0)
+			throw invalid_argument("batch window must be positive");
+		bool allAssigned = true;
+		for (size_t begin = 0; begin < requests.size(); begin += window){
+			int windowRows = min((size_t)window, requests.size() - begin);
+			auto start = chrono::steady_clock::now();
+			
+			vector<int> colElevator;
+			vector<int> colRank;
+			for (int i = 0; i < numOfElevators; i++){
+				int slots = min(maxElevatorRequests - elevators[i]->getNumRequests(), windowRows);
+				for (int k = 0; k < slots; k++){
+					colElevator.push_back(i);
+					colRank.push_back(elevators[i]->getNumRequests() + k);
+				}
+			}
+			int realCols = colElevator.size();
+			int rows = windowRows;
+			if (budgetMicros > 0){
+				double leftNs = budgetMicros * 1e3 - chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+				rows = min(rows, (int)sqrt(max(leftNs, 0.0) / (solverNsPerUnit * max(realCols, 1))));
+			}
+			int cols = max(realCols, rows);   // padding columns stand for "not assigned"
+			const long long NOT_ASSIGNED = 1LL << 40;
+			vector<long long> cost((size_t)rows * cols, NOT_ASSIGNED);
+			for (int r = 0; r < rows; r++){
+				int outFloor = requests[begin + r].first, inFloor = requests[begin + r].second;
+				ElevatorDirection dir = (outFloor < inFloor ? UP : DOWN);
+				int lastElevator = -1, reach = 0;
+				for (int c = 0; c < realCols; c++){
+					if (colElevator[c] != lastElevator){
+						lastElevator = colElevator[c];
+						reach = elevators[lastElevator]->ticksToReach(outFloor, dir);
+					}
+					cost[(size_t)r * cols + c] = reach + colRank[c];
+				}
+			}
+			auto solveStart = chrono::steady_clock::now();
+			vector<int> colOfRow = minCostAssignment(cost, rows, cols, budgetMicros > 0, 
+			                                         start + chrono::microseconds((long long)budgetMicros));
+			double units = (double)rows * rows * cols;
+			if (units > 1e4)
+				solverNsPerUnit = chrono::duration<double, nano>(chrono::steady_clock::now() - solveStart).count() / units;
+			colOfRow.resize(windowRows, -1);
+			
+			for (int r = 0; r < windowRows; r++){
+				int outFloor = requests[begin + r].first, inFloor = requests[begin + r].second;
+				bool success;
+				if (colOfRow[r] == -1){
+					batchStats.greedyFallbacks++;
+					success = assignUserRequest(outFloor, inFloor);
+				}
+				else if (colOfRow[r] < realCols){
+					addToElevator(colElevator[colOfRow[r]], outFloor, inFloor);
+					success = true;
+				}
+				else
+					success = false;
+				if (!success){
+					batchStats.unassigned++;
+					allAssigned = false;
+					if (verbose)
+						cout << "unable to assign request (outFloor: " << outFloor << ", inFloor: " << inFloor << ")" << endl;
+				}
+			}
+			double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			batchStats.batches++;
+			batchStats.requests += windowRows;
+			batchStats.totalSeconds += seconds;
+			batchStats.maxSeconds = max(batchStats.maxSeconds, seconds);
+		}
+		if (verbose){
+			cout << "batch assignment " << (allAssigned ? "successful" : "incomplete") << endl;
+			printRequestsAssignment();
+			cout << "-------------------------" << endl;
+		}
+		return allAssigned;
+	}
+	
+	void syncBank(int idx){
+		bank.update(idx, elevators[idx]->getCurrFloor(), elevators[idx]->getCurrMoveDir(), elevators[idx]->getNumOfPeople(), 
+		            elevators[idx]->getNumRequests());
+	}
+	
+	void buildDispatchIndex(){
+		availableUp.clear();
+		availableDown.clear();
+		availableAll.clear();
+		for (int i = 0; i < numOfElevators; i++){
+			if (!bank.isAvailable(i))
+				continue;
+			if (elevators[i]->getCurrMoveDir() == UP)
+				availableUp.insert(make_pair(bank.floorOf(i), i));
+			else
+				availableDown.insert(make_pair(bank.floorOf(i), i));
+			availableAll.insert(i);
+		}
+		indexFresh = true;
+	}
+	
+	// lowest-index available elevator moving "dir" at the highest floor below "floor", or -1
+	int nearestBelow(ElevatorDirection dir, int floor){
+		if (!indexFresh)
+			return bank.nearestBelow(dir, floor);
+		set<pair<int, int>>& available = (dir == UP ? availableUp : availableDown);
+		auto it = available.lower_bound(make_pair(floor, INT_MIN));
+		if (it == available.begin())
+			return -1;
+		--it;
+		return available.lower_bound(make_pair(it->first, INT_MIN))->second;
+	}
+	
+	// lowest-index available elevator moving "dir" at the lowest floor at or above "floor", or -1
+	int nearestAtOrAbove(ElevatorDirection dir, int floor){
+		if (!indexFresh)
+			return bank.nearestAtOrAbove(dir, floor);
+		set<pair<int, int>>& available = (dir == UP ? availableUp : availableDown);
+		auto it = available.lower_bound(make_pair(floor, INT_MIN));
+		return it == available.end() ? -1 : it->second;
+	}
+	
+	void addToElevator(int idx, int outFloor, int inFloor){
+		elevators[idx]->addNewRequest(outFloor, inFloor);
+		bank.addRequest(idx);
+		if (indexFresh && !bank.isAvailable(idx)){
+			set<pair<int, int>>& available = (elevators[idx]->getCurrMoveDir() == UP ? availableUp : availableDown);
+			available.erase(make_pair(bank.floorOf(idx), idx));
+			availableAll.erase(idx);
+		}
+	}
+	
+	// lowest-index available elevator, or -1
+	int firstAvailable(){
+		if (!indexFresh)
+			return bank.firstAvailable();
+		return availableAll.empty() ? -1 : *availableAll.begin();
+	}
+	
+	// place one request with the dispatch policy, false if no elevator can take it now
+	bool assignUserRequest(int outFloor, int inFloor){
+		if (!indexFresh && (indexLastTick || ++scansSinceMove > SCANS_BEFORE_INDEX))
+			buildDispatchIndex();
+		int idx = policy->chooseElevator(*this, outFloor, inFloor);
+		if (idx == -1)
+			return false;
+		if (idx < 0 || idx >= numOfElevators || !bank.isAvailable(idx))
+			throw out_of_range("dispatch policy chose an elevator that cannot take the request");
+		addToElevator(idx, outFloor, inFloor);
+		return true;
 	}
 	
 	void printRequestsAssignment(){
@@ -375,30 +1774,1819 @@ public:
 	
 	
 	bool allFinish(){
-		for (int i = 0; i < numOfElevators; i++){
-			if (!elevators[i]->finish())
-				return false;
-		}
-		return true;
+		return bank.allFinished();
 	}
 	
-	void run(){
-		while(!allFinish()){
+	// one tick: step every elevator (in parallel if there is a pool and nothing is printed) and mirror it into
+	// the bank, then trace and print; returns whether every elevator is finished afterwards
+	bool stepAll(){
+		if (pool != NULL && !verbose){
+			int parts = pool->size();
+			pool->runParts([&](int part){
+				for (int i = (long long)numOfElevators * part / parts; i < (long long)numOfElevators * (part + 1) / parts; i++){
+					elevators[i]->step();
+					syncBank(i);
+				}
+			});
+		}
+		else {
 			for (int i = 0; i < numOfElevators; i++){
-				cout << "elevator " << i << " is at floor " << elevators[i]->getCurrFloor() << endl;
+				if (verbose)
+					cout << "elevator " << i << " is at floor " << elevators[i]->getCurrFloor() << endl;
 				elevators[i]->step();
+				syncBank(i);
 			}
+		}
+		indexLastTick = indexFresh;
+		indexFresh = false;
+		scansSinceMove = 0;
+		bool finished = allFinish();
+		currTick++;
+		if (traceFile != NULL && currTick % traceEvery == 0)
+			writeTrace();
+		if (verbose){
 			printRequestsAssignment();
 			printRequestsProcess();
 			cout << "----------------------" << endl;
 		}
-		cout << "finish all" << endl;
+		return finished;
+	}
+	
+	void run(){
+		auto start = chrono::steady_clock::now();
+		bool finished = allFinish();
+		while (!finished)
+			finished = stepAll();
+		wallSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		if (verbose)
+			cout << "finish all" << endl;
 	}	
-};
-
-
-int main() {
-	int num_elevators = 3;
+	
+	/* streaming mode: instead of loadRequests/assignRequests/run, pull timestamped requests from "source" as
+	   the ticks advance and assign each one online when its tick comes. A request that no elevator can take
+	   waits in a FIFO backlog and is retried every tick; while the backlog holds maxBacklog requests the
+	   source is not read any further. So memory is bounded by the elevators' maxRequests and maxBacklog,
+	   however long the trace is. Returns when the source is exhausted and every request is delivered. */
+	void runStream(RequestSource& source, int maxBacklog = 1 << 16){
+		if (maxBacklog <= 0)
+			throw invalid_argument("backlog must hold at least one request");
+		auto start = chrono::steady_clock::now();
+		deque<RequestRecord> backlog;
+		RequestRecord next;
+		bool hasNext = source.next(next);
+		bool finished = allFinish();
+		while (hasNext || !backlog.empty() || !finished){
+			while (!backlog.empty()){
+				if (!assignUserRequest(backlog.front().outFloor, backlog.front().inFloor))
+					break;
+				backlog.pop_front();
+			}
+			while (hasNext && next.tick <= currTick && (int)backlog.size() < maxBacklog){
+				if (next.outFloor < 1 || next.outFloor > numOfFloors || next.inFloor < 1 || next.inFloor > numOfFloors || next.outFloor == next.inFloor)
+					throw invalid_argument("request floors out of range");
+				if (!backlog.empty() || !assignUserRequest(next.outFloor, next.inFloor))
+					backlog.push_back(next);
+				streamedRequests++;
+				RequestRecord following;
+				hasNext = source.next(following);
+				if (hasNext && following.tick < next.tick)
+					throw invalid_argument("requests must be sorted by tick");
+				next = following;
+			}
+			peakBacklog = max(peakBacklog, (long long)backlog.size());
+			finished = stepAll();
+		}
+		wallSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+	
+	long long getStreamedRequests(){
+		return streamedRequests;
+	}
+	
+	long long getPeakBacklog(){
+		return peakBacklog;
+	}
+};
+
+
+// same choices as scanning upList, downList and then all elevators in index order
+int NearestCarPolicy::chooseElevator(Controller& controller, int outFloor, int inFloor){
+	bool UserWantsUp = (outFloor < inFloor);
+	int minDistIdx;
+	if (UserWantsUp){
+		// wants to go up, try to assign to the closest elevator moving up BELOW the outFloor
+		minDistIdx = controller.nearestBelow(UP, outFloor);
+	} 
+	else {
+		// wants to go down, try to assign to the closest elevator moving down ABOVE the outFloor
+		minDistIdx = controller.nearestAtOrAbove(DOWN, outFloor + 1);
+	}
+	if (minDistIdx != -1)
+		return minDistIdx;
+	
+	//if not successful, try the other moving direction, find the closest on either side
+	ElevatorDirection secondPrimary = (UserWantsUp ? DOWN : UP);
+	int below = controller.nearestBelow(secondPrimary, outFloor);
+	int above = controller.nearestAtOrAbove(secondPrimary, outFloor);
+	if (below != -1 && above != -1){
+		int belowDist = outFloor - controller.getElevatorFloor(below);
+		int aboveDist = controller.getElevatorFloor(above) - outFloor;
+		return (belowDist < aboveDist || (belowDist == aboveDist && below < above) ? below : above);
+	}
+	if (below != -1 || above != -1)
+		return (below != -1 ? below : above);
+	
+	//if still not successful, take the first available elevator
+	return controller.firstAvailable();
+}
+
+
+//---------------------- discrete-event simulation ----------------
+/* Controller::run() moves every elevator one floor per tick whether or not anything happens, and a tick
+   has no unit of time. EventSimulation keeps a timestamp-ordered event queue instead and only does work
+   at passenger arrivals, when a car reaches a floor it has to stop at, and when its doors close.
+   A moving car is not visited at the floors it passes: its next stop event is scheduled directly at
+   departTime + distance * floorTravel. If a new call lands ahead of it on the way, the stop is moved
+   earlier by bumping the car's version, which makes the already queued event stale.
+   This pays off when calls are sparse: a 24 h day of 240 cars and 20k calls runs about 15x faster than
+   streaming it through Controller. The ETA policy only costs the cars that forCarsNear finds in the
+   position index (about 6 of 240 per call), but with 1M calls the per-event work still adds up and the
+   same day takes about 2.4x longer than the tick engine (benchEventEngine). */
+
+// a hall call at "time" seconds: a passenger at outFloor wants to go to inFloor
+struct TimedRequest {
+	double time;
+	int outFloor;
+	int inFloor;
+};
+
+// seconds spent per floor of travel, opening and closing the doors, and per person getting in or out
+struct SimulationTiming {
+	double floorTravel;
+	double doorOpen;
+	double doorClose;
+	double boardPerPerson;
+};
+
+struct EventMetrics {
+	long long events;
+	long long passengers;
+	long long floorsTravelled;
+	double simSeconds;
+	double totalWait;      // from the call until the doors open for the passenger
+	double totalJourney;   // from the call until the passenger gets out
+	double maxWait;
+	double p95Wait;
+	double p99Wait;
+	double dispatchSeconds;   // wall time spent choosing cars for arrivals
+	double wallSeconds;
+};
+
+// minimum estimated time for the car to reach the caller, counting the stops it already owes
+class EtaPolicy : public DispatchPolicy {
+public:
+	string name() { return "ETA cost"; }
+	int chooseElevator(Controller& controller, int outFloor, int inFloor);
+	int chooseCar(const EventSimulation& sim, const TimedRequest& req);
+};
+
+/* lookahead dispatch: give the request to each available elevator in turn on a branch restored from the
+   live state, simulate "horizon" ticks ahead and keep the elevator with the least waiting at the end.
+   The branch and the checkpoint are reused between calls, and the branch is rebuilt whenever the live
+   Controller has a different shape, so a policy serves one live Controller at a time. */
+class RolloutPolicy : public DispatchPolicy {
+private:
+	int horizon;
+	SimulationCheckpoint checkpoint;
+	Controller* branch;
+	
+public:
+	RolloutPolicy(int horizon) : horizon(horizon), branch(NULL) {
+		if (horizon < 0)
+			throw invalid_argument("the horizon cannot be negative");
+	}
+	RolloutPolicy(const RolloutPolicy&) = delete;
+	RolloutPolicy& operator=(const RolloutPolicy&) = delete;
+	~RolloutPolicy(){
+		delete branch;
+	}
+	string name() { return to_string(horizon) + "-tick rollouts"; }
+	
+	int chooseElevator(Controller& controller, int outFloor, int inFloor){
+		controller.checkpoint(checkpoint);
+		if (branch == NULL || !branch->sameShape(checkpoint)){
+			delete branch;
+			branch = new Controller(checkpoint);
+		}
+		int best = -1;
+		long long bestCost = LLONG_MAX;
+		for (int i = 0; i < checkpoint.numOfElevators; i++){
+			if (!controller.isElevatorAvailable(i))
+				continue;
+			branch->restore(checkpoint);
+			branch->addToElevator(i, outFloor, inFloor);
+			for (int t = 0; t < horizon; t++)
+				branch->stepAll();
+			long long cost = branch->getMetrics().waitTicks;
+			if (cost < bestCost){
+				bestCost = cost;
+				best = i;
+			}
+		}
+		return best;
+	}
+};
+
+/* the floors are split into numZones contiguous zones and car i serves zone i % numZones only.
+   A call belongs to the zone of the floor it is made from, except that lobby calls (floor 1) go to the
+   zone of their destination. */
+class ZoningPolicy : public DispatchPolicy {
+private:
+	int numZones;
+	
+public:
+	ZoningPolicy(int zones) : numZones(zones) {
+		if (zones <= 0)
+			throw invalid_argument("need at least one zone");
+	}
+	string name() { return "zoning (" + to_string(numZones) + " zones)"; }
+	int chooseCar(const EventSimulation& sim, const TimedRequest& req);
+};
+
+/* destination dispatch: the caller keys in the destination at the hall, so the cost can count the
+   stops a car would add. Riders going between floors a car already stops at ride along for free,
+   which groups riders by destination and cuts the number of stops per trip. */
+class DestinationDispatchPolicy : public DispatchPolicy {
+public:
+	string name() { return "destination dispatch"; }
+	int chooseCar(const EventSimulation& sim, const TimedRequest& req);
+};
+
+
+class EventSimulation {
+public:
+	enum CarState {IDLE, MOVING, DOORS};
+	
+	struct Rider {
+		double callTime;
+		int inFloor;
+	};
+	
+	struct Car {
+		int floor;            // the floor the car is at, or departed from when MOVING
+		int target;           // next stop when MOVING
+		double departTime;
+		ElevatorDirection dir;
+		CarState state;
+		int version;
+		int numOfPeople;
+		int numWaiting;
+		int numStops;         // floors with someone waiting for or riding in this car
+		FloorSet stops;       // those floors, for finding the next stop without walking every floor
+		vector<vector<Rider>> waiting;   // per floor, riders assigned to this car waiting to get in
+		vector<vector<Rider>> riding;    // per floor, riders inside the car getting out there
+	};
+	
+private:
+	enum EventType {ARRIVAL, STOP_REACHED, DOORS_CLOSED};
+	
+	struct Event {
+		double time;
+		long long seq;     // insertion order, breaks ties between events at the same time
+		EventType type;
+		int car;
+		int version;       // a STOP_REACHED/DOORS_CLOSED event is stale if the car's version has moved on
+		
+		bool operator>(const Event& other) const {
+			return time != other.time ? time > other.time : seq > other.seq;
+		}
+	};
+	
+	int numOfFloors;
+	int capacity;
+	SimulationTiming timing;
+	double perFloor;      // 1 / timing.floorTravel
+	vector<Car> cars;
+	priority_queue<Event, vector<Event>, greater<Event>> events;
+	long long seq;
+	EventMetrics metrics;
+	vector<float> waits;
+	EtaPolicy defaultPolicy;
+	DispatchPolicy* policy;
+	
+	/* the cars bucketed by position, one ring of buckets per state and direction, so a policy can walk
+	   outward from the caller instead of scanning every car. A parked car's key is its floor. All the cars
+	   moving one way go at the same speed, so a moving car is keyed by where it would have been at time 0:
+	   a car at position p at time t has key p - t / floorTravel going up (p + t / floorTravel going down),
+	   which only changes when the car stops. A bucket holds the cars whose key has the same integer part.
+	   At any one time the keys in use span fewer than numOfFloors + 1 integers, so a ring of that many
+	   buckets never mixes two of them, and moving a car between buckets is O(1). Walks skip the empty
+	   buckets with a bitset of the occupied ones. */
+	enum IndexSet {IDLE_CARS, MOVING_UP, MOVING_DOWN, DOORS_UP, DOORS_DOWN, NUM_INDEX_SETS};
+	int ringSize;
+	vector<vector<int>> carIndex[NUM_INDEX_SETS];
+	FloorSet occupied[NUM_INDEX_SETS];
+	vector<int> indexSetOf, indexBucket, indexSlot;   // per car, where it is filed, -1 before it is
+	vector<double> indexKey;
+	vector<int> indexLoad;                            // per car, numOfPeople + numWaiting
+	
+	// the integer part of a key, rounding down also below zero (std::floor is a library call here)
+	static long long keyFloor(double key){
+		long long whole = (long long)key;
+		return whole - (key < whole);
+	}
+	
+	int ringBucket(long long key) const {
+		return (int)(((key % ringSize) + ringSize) % ringSize);
+	}
+	
+	// file car c under its current state, after a change of state, floor or direction
+	void reindex(int c){
+		const Car& car = cars[c];
+		int which;
+		double key = car.floor;
+		if (car.state == IDLE)
+			which = IDLE_CARS;
+		else if (car.state == DOORS)
+			which = (car.dir == UP ? DOORS_UP : DOORS_DOWN);
+		else {
+			which = (car.dir == UP ? MOVING_UP : MOVING_DOWN);
+			key += (car.dir == UP ? -car.departTime : car.departTime) * perFloor;
+		}
+		if (which == indexSetOf[c] && key == indexKey[c])
+			return;
+		if (indexSetOf[c] != -1){
+			vector<int>& bucket = carIndex[indexSetOf[c]][indexBucket[c]];
+			bucket[indexSlot[c]] = bucket.back();
+			indexSlot[bucket.back()] = indexSlot[c];
+			bucket.pop_back();
+			if (bucket.empty())
+				occupied[indexSetOf[c]].reset(indexBucket[c]);
+		}
+		indexSetOf[c] = which;
+		indexBucket[c] = ringBucket(keyFloor(key));
+		vector<int>& bucket = carIndex[which][indexBucket[c]];
+		indexSlot[c] = bucket.size();
+		indexKey[c] = key;
+		bucket.push_back(c);
+		occupied[which].set(indexBucket[c]);
+	}
+	
+	// where the cars of set "which" stand at "time" is their key plus this
+	double indexShift(int which, double time) const {
+		if (which == MOVING_UP)
+			return time * perFloor;
+		if (which == MOVING_DOWN)
+			return -time * perFloor;
+		return 0;
+	}
+	
+	/* visit the cars of one index set bucket by bucket, from key "from" down to "to" or up to "to", while
+	   "bound", a lower bound on the floors to reach the caller, does not pass the limit returned by the
+	   last visit. Going down the bound is bound - position, going up bound + position, so it grows along
+	   the walk and the walk stops at the first bucket that is out of reach as a whole. A car in reach is
+	   still skipped if its riders, at floorsPerRider each, put it out of reach. */
+	template <typename Visit>
+	void walkDown(int which, long long from, long long to, double shift, double bound, double floorsPerRider, double& limit, 
+	              Visit& visit) const {
+		const FloorSet& inUse = occupied[which];
+		int bucket = ringBucket(from);
+		for (long long key = from; key >= to; key--, bucket = (bucket == 0 ? ringSize - 1 : bucket - 1)){
+			int found = inUse.prev(bucket);
+			if (found == -1){
+				found = inUse.prev(ringSize - 1);
+				if (found == -1)
+					return;
+				key -= bucket + ringSize - found;
+			}
+			else
+				key -= bucket - found;
+			bucket = found;
+			if (key < to || bound - (key + 1 + shift) > limit)
+				return;
+			for (int c : carIndex[which][bucket])
+				if (bound - (indexKey[c] + shift) + indexLoad[c] * floorsPerRider <= limit)
+					limit = visit(c);
+		}
+	}
+	
+	template <typename Visit>
+	void walkUp(int which, long long from, long long to, double shift, double bound, double floorsPerRider, double& limit, 
+	            Visit& visit) const {
+		const FloorSet& inUse = occupied[which];
+		int bucket = ringBucket(from);
+		for (long long key = from; key <= to; key++, bucket = (bucket == ringSize - 1 ? 0 : bucket + 1)){
+			int found = inUse.next(bucket);
+			if (found == -1){
+				found = inUse.next(0);
+				if (found == -1)
+					return;
+				key += ringSize - bucket + found;
+			}
+			else
+				key += found - bucket;
+			bucket = found;
+			if (key > to || bound + (key + shift) > limit)
+				return;
+			for (int c : carIndex[which][bucket])
+				if (bound + (indexKey[c] + shift) + indexLoad[c] * floorsPerRider <= limit)
+					limit = visit(c);
+		}
+	}
+	
+	void schedule(double time, EventType type, int car){
+		int version = (car >= 0 ? cars[car].version : 0);
+		events.push(Event{time, seq++, type, car, version});
+	}
+	
+	bool hasStop(const Car& car, int floor) const {
+		return car.stops.test(floor);
+	}
+	
+	void addStop(Car& car, int floor){
+		if (!hasStop(car, floor)){
+			car.stops.set(floor);
+			car.numStops++;
+		}
+	}
+	
+	// the closest floor with a stop strictly beyond "from" in direction "dir", or -1
+	int nextStop(Car& car, int from, ElevatorDirection dir){
+		return dir == UP ? car.stops.next(from + 1) : car.stops.prev(from - 1);
+	}
+	
+	// pick a direction with work in it and head for the nearest stop, or go idle
+	void startMoving(int c, double time){
+		Car& car = cars[c];
+		int target = nextStop(car, car.floor, car.dir);
+		if (target == -1){
+			car.dir = (car.dir == UP ? DOWN : UP);
+			target = nextStop(car, car.floor, car.dir);
+		}
+		if (target == -1){
+			car.state = IDLE;
+			reindex(c);
+			return;
+		}
+		car.state = MOVING;
+		car.target = target;
+		car.departTime = time;
+		car.version++;
+		reindex(c);
+		schedule(time + abs(target - car.floor) * timing.floorTravel, STOP_REACHED, c);
+	}
+	
+	// let riders for this floor out and waiting riders in, in the order they called, up to capacity
+	void openDoors(int c, double time){
+		Car& car = cars[c];
+		vector<Rider>& out = car.riding[car.floor];
+		for (Rider& r : out)
+			metrics.totalJourney += time - r.callTime;
+		int moved = out.size();
+		car.numOfPeople -= out.size();
+		indexLoad[c] -= out.size();
+		out.clear();
+		
+		vector<Rider>& in = car.waiting[car.floor];
+		size_t boarded = 0;
+		while (boarded < in.size() && car.numOfPeople < capacity){
+			const Rider& r = in[boarded++];
+			double wait = time - r.callTime;
+			metrics.totalWait += wait;
+			metrics.maxWait = max(metrics.maxWait, wait);
+			metrics.passengers++;
+			waits.push_back(wait);
+			addStop(car, r.inFloor);
+			car.riding[r.inFloor].push_back(r);
+			car.numOfPeople++;
+			car.numWaiting--;
+			moved++;
+		}
+		in.erase(in.begin(), in.begin() + boarded);
+		// nobody rides to the floor the car is at, so it stays a stop only for riders left behind
+		if (in.empty() && hasStop(car, car.floor)){
+			car.stops.reset(car.floor);
+			car.numStops--;
+		}
+		car.state = DOORS;
+		car.version++;
+		reindex(c);
+		schedule(time + timing.doorOpen + timing.doorClose + moved * timing.boardPerPerson, DOORS_CLOSED, c);
+	}
+	
+	void arrive(const TimedRequest& req){
+		auto start = chrono::steady_clock::now();
+		int c = policy->chooseCar(*this, req);
+		metrics.dispatchSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		if (c < 0 || c >= (int)cars.size())
+			throw out_of_range("dispatch policy chose a car that does not exist");
+		Car& car = cars[c];
+		addStop(car, req.outFloor);
+		car.waiting[req.outFloor].push_back(Rider{req.time, req.inFloor});
+		car.numWaiting++;
+		indexLoad[c]++;
+		
+		if (car.state == IDLE){
+			if (car.floor == req.outFloor)
+				openDoors(c, req.time);
+			else {
+				car.dir = (req.outFloor > car.floor ? UP : DOWN);
+				startMoving(c, req.time);
+			}
+		}
+		else if (car.state == MOVING){
+			// a new stop on the way, before the current target: stop there first
+			int reachable = positionAt(c, req.time);
+			bool ahead = (car.dir == UP ? reachable <= req.outFloor && req.outFloor < car.target
+			                            : reachable >= req.outFloor && req.outFloor > car.target);
+			if (ahead){
+				car.target = req.outFloor;
+				car.version++;
+				schedule(car.departTime + abs(car.target - car.floor) * timing.floorTravel, STOP_REACHED, c);
+			}
+		}
+		// a car with open doors picks the new rider up when the doors close
+	}
+	
+	void stopReached(int c, double time){
+		Car& car = cars[c];
+		metrics.floorsTravelled += abs(car.target - car.floor);
+		car.floor = car.target;
+		openDoors(c, time);
+	}
+	
+	void doorsClosed(int c, double time){
+		Car& car = cars[c];
+		if (!car.waiting[car.floor].empty() && car.numOfPeople < capacity)
+			openDoors(c, time);
+		else
+			startMoving(c, time);
+	}
+	
+public:
+	// "dispatch" is not owned, NULL uses EtaPolicy
+	EventSimulation(int num_elevators, int num_floors, int elevator_cap, SimulationTiming timing, unsigned seed,
+	                DispatchPolicy* dispatch = NULL){
+		if (num_elevators <= 0 || num_floors < 2 || elevator_cap <= 0)
+			throw invalid_argument("need at least one elevator, two floors and a positive capacity");
+		numOfFloors = num_floors;
+		capacity = elevator_cap;
+		this->timing = timing;
+		perFloor = 1 / timing.floorTravel;
+		seq = 0;
+		metrics = EventMetrics{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+		policy = (dispatch != NULL ? dispatch : &defaultPolicy);
+		
+		mt19937 rng(seed);
+		for (int i = 0; i < num_elevators; i++){
+			Car car;
+			car.floor = 1 + rng() % num_floors;
+			car.target = car.floor;
+			car.departTime = 0;
+			car.dir = (rng() % 2 ? UP : DOWN);
+			car.state = IDLE;
+			car.version = 0;
+			car.numOfPeople = 0;
+			car.numWaiting = 0;
+			car.numStops = 0;
+			car.stops = FloorSet(num_floors);
+			car.waiting.resize(num_floors + 1);
+			car.riding.resize(num_floors + 1);
+			cars.push_back(car);
+		}
+		ringSize = num_floors + 1;
+		for (int i = 0; i < NUM_INDEX_SETS; i++){
+			carIndex[i].resize(ringSize);
+			occupied[i] = FloorSet(ringSize);
+		}
+		indexSetOf.assign(num_elevators, -1);
+		indexBucket.assign(num_elevators, 0);
+		indexSlot.assign(num_elevators, 0);
+		indexKey.assign(num_elevators, 0);
+		indexLoad.assign(num_elevators, 0);
+		for (int i = 0; i < num_elevators; i++)
+			reindex(i);
+	}
+	
+	/* run the simulation over requests sorted by time, until every passenger is delivered.
+	   Only the next arrival is in the event queue at any time and each car has at most one live
+	   event. Moving a car's stop earlier leaves its old STOP_REACHED behind as a stale entry, which
+	   stays queued until its time comes and is then skipped. */
+	void run(const vector<TimedRequest>& requests){
+		auto start = chrono::steady_clock::now();
+		size_t nextArrival = 0;
+		if (nextArrival < requests.size())
+			schedule(requests[nextArrival].time, ARRIVAL, -1);
+		
+		while (!events.empty()){
+			Event e = events.top();
+			events.pop();
+			if (e.type != ARRIVAL && e.version != cars[e.car].version)
+				continue;
+			metrics.events++;
+			metrics.simSeconds = e.time;
+			
+			if (e.type == ARRIVAL){
+				const TimedRequest& req = requests[nextArrival++];
+				if (req.outFloor < 1 || req.outFloor > numOfFloors || req.inFloor < 1 || req.inFloor > numOfFloors || req.outFloor == req.inFloor)
+					throw invalid_argument("request floors out of range");
+				arrive(req);
+				if (nextArrival < requests.size()){
+					if (requests[nextArrival].time < req.time)
+						throw invalid_argument("requests must be sorted by time");
+					schedule(requests[nextArrival].time, ARRIVAL, -1);
+				}
+			}
+			else if (e.type == STOP_REACHED)
+				stopReached(e.car, e.time);
+			else
+				doorsClosed(e.car, e.time);
+		}
+		if (!waits.empty()){
+			nth_element(waits.begin(), waits.begin() + waits.size() * 95 / 100, waits.end());
+			metrics.p95Wait = waits[waits.size() * 95 / 100];
+			nth_element(waits.begin(), waits.begin() + waits.size() * 99 / 100, waits.end());
+			metrics.p99Wait = waits[waits.size() * 99 / 100];
+		}
+		metrics.wallSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
+	
+	EventMetrics getMetrics(){
+		return metrics;
+	}
+	
+	//---- read-only state for the dispatch policies ----
+	int getNumCars() const {
+		return cars.size();
+	}
+	
+	int getNumFloors() const {
+		return numOfFloors;
+	}
+	
+	int getCapacity() const {
+		return capacity;
+	}
+	
+	const SimulationTiming& getTiming() const {
+		return timing;
+	}
+	
+	const Car& getCar(int c) const {
+		return cars[c];
+	}
+	
+	// the floor a car could still stop at by "time": where it stands, or the next floor a moving car has not passed yet
+	int positionAt(int c, double time) const {
+		const Car& car = cars[c];
+		if (car.state != MOVING)
+			return car.floor;
+		double floors = (time - car.departTime) * perFloor;
+		int passed = (int)floors;
+		if (passed < floors)
+			passed++;
+		return car.floor + (car.dir == UP ? passed : -passed);
+	}
+	
+	/* visit(c) for every car whose floorsToReach(c, floor, dir, time), plus floorsPerRider for each rider
+	   waiting for or riding in it, can still be within "limit", where "limit" is what the last visit returned
+	   (it may only shrink). Each index set is walked outward from the caller, so a policy whose cost is at
+	   least that sum (in floors) sees every car that could win, without looking at the cars out of reach.
+	   Positions are bounded from below less one floor, for a moving car between floors, plus rounding. */
+	template <typename Visit>
+	void forCarsNear(int floor, ElevatorDirection dir, double time, double floorsPerRider, Visit visit) const {
+		const double slack = 1 + 1e-6;
+		int n = numOfFloors;
+		double limit = 1e300;
+		// where the keys in use start and end in each set, and the key of the caller's floor
+		double shift[NUM_INDEX_SETS];
+		long long lowest[NUM_INDEX_SETS], highest[NUM_INDEX_SETS], caller[NUM_INDEX_SETS];
+		for (int which = 0; which < NUM_INDEX_SETS; which++){
+			shift[which] = indexShift(which, time);
+			lowest[which] = keyFloor(1 - shift[which]);
+			highest[which] = keyFloor(n - shift[which]);
+			caller[which] = keyFloor(floor - shift[which]);
+		}
+		// the closest cars first, so the limit drops early: idle cars go straight there, and so do the cars
+		// coming towards the caller in its direction (the caller's bucket also goes into the walks below)
+		walkDown(IDLE_CARS, floor, 1, 0, floor - 1e-6, floorsPerRider, limit, visit);
+		walkUp(IDLE_CARS, floor + 1, n, 0, -floor - 1e-6, floorsPerRider, limit, visit);
+		int coming[] = {dir == UP ? MOVING_UP : MOVING_DOWN, dir == UP ? DOORS_UP : DOORS_DOWN};
+		for (int which : coming){
+			if (dir == UP)
+				walkDown(which, caller[which], lowest[which], shift[which], floor - slack, floorsPerRider, limit, visit);
+			else
+				walkUp(which, caller[which], highest[which], shift[which], -floor - slack, floorsPerRider, limit, visit);
+		}
+		// the rest go to the top (bottom) floor and back
+		for (int which : {MOVING_UP, DOORS_UP})
+			walkDown(which, highest[which], dir == UP ? caller[which] : lowest[which], shift[which], 2 * n - floor - slack, 
+			         floorsPerRider, limit, visit);
+		for (int which : {MOVING_DOWN, DOORS_DOWN})
+			walkUp(which, lowest[which], dir == DOWN ? caller[which] : highest[which], shift[which], floor - 2 - slack, 
+			       floorsPerRider, limit, visit);
+	}
+	
+	// someone is waiting for car c at "floor", or riding it to "floor"
+	bool stopsAt(int c, int floor) const {
+		return hasStop(cars[c], floor);
+	}
+	
+	/* floors car c travels before it can pick up at "floor" heading in "dir": straight there if it is idle or
+	   already coming that way, otherwise to the end of its sweep and back */
+	int floorsToReach(int c, int floor, ElevatorDirection dir, double time) const {
+		const Car& car = cars[c];
+		int pos = positionAt(c, time);
+		if (car.state == IDLE || (car.dir == dir && (dir == UP ? pos <= floor : pos >= floor)))
+			return abs(pos - floor);
+		if (car.dir == UP)
+			return (numOfFloors - pos) + (numOfFloors - floor);
+		return (pos - 1) + (floor - 1);
+	}
+};
+
+//---- dispatch policies ----
+/* the same chain over the cars, a car being available while its riders and waiting callers are below
+   capacity. An arrival cannot wait for a car to free up, so with every car full it goes to the least loaded. */
+int NearestCarPolicy::chooseCar(const EventSimulation& sim, const TimedRequest& req){
+	ElevatorDirection wants = (req.outFloor < req.inFloor ? UP : DOWN);
+	int bestSame = INT_MAX, bestSameIdx = -1, bestOther = INT_MAX, bestOtherIdx = -1, firstAvailable = -1;
+	int leastLoad = INT_MAX, leastLoadedIdx = 0;
+	for (int i = 0; i < sim.getNumCars(); i++){
+		const EventSimulation::Car& car = sim.getCar(i);
+		int load = car.numOfPeople + car.numWaiting;
+		if (load < leastLoad){
+			leastLoad = load;
+			leastLoadedIdx = i;
+		}
+		if (load >= sim.getCapacity())
+			continue;
+		if (firstAvailable == -1)
+			firstAvailable = i;
+		int pos = sim.positionAt(i, req.time);
+		int dist = abs(pos - req.outFloor);
+		if (car.dir == wants){
+			bool coming = (wants == UP ? pos < req.outFloor : pos > req.outFloor);
+			if (coming && dist < bestSame){
+				bestSame = dist;
+				bestSameIdx = i;
+			}
+		}
+		else if (dist < bestOther){
+			bestOther = dist;
+			bestOtherIdx = i;
+		}
+	}
+	if (bestSameIdx != -1)
+		return bestSameIdx;
+	if (bestOtherIdx != -1)
+		return bestOtherIdx;
+	return firstAvailable != -1 ? firstAvailable : leastLoadedIdx;
+}
+
+// seconds until car c could pick the caller up, plus a stop's worth of time for every rider it already owes a stop
+double etaCost(const EventSimulation& sim, int c, const TimedRequest& req){
+	const SimulationTiming& timing = sim.getTiming();
+	const EventSimulation::Car& car = sim.getCar(c);
+	double stopTime = timing.doorOpen + timing.doorClose + timing.boardPerPerson;
+	int floors = sim.floorsToReach(c, req.outFloor, req.outFloor < req.inFloor ? UP : DOWN, req.time);
+	return floors * timing.floorTravel + (car.numOfPeople + car.numWaiting) * stopTime;
+}
+
+// the cost is at least the travel time, so only the cars near enough in the position index are costed
+int EtaPolicy::chooseCar(const EventSimulation& sim, const TimedRequest& req){
+	const SimulationTiming& timing = sim.getTiming();
+	double stopTime = timing.doorOpen + timing.doorClose + timing.boardPerPerson;
+	double bestCost = 1e300;
+	int best = -1;
+	sim.forCarsNear(req.outFloor, req.outFloor < req.inFloor ? UP : DOWN, req.time, stopTime / timing.floorTravel, [&](int c){
+		double cost = etaCost(sim, c, req);
+		// the lowest numbered car wins a tie, as in a scan over all the cars
+		if (cost < bestCost || (cost == bestCost && c < best)){
+			bestCost = cost;
+			best = c;
+		}
+		return bestCost / timing.floorTravel;
+	});
+	return best;
+}
+
+// the available elevator that reaches the caller soonest along its current sweep, one tick per request it holds
+int EtaPolicy::chooseElevator(Controller& controller, int outFloor, int inFloor){
+	ElevatorDirection dir = (outFloor < inFloor ? UP : DOWN);
+	int bestCost = INT_MAX, best = -1;
+	for (int i = 0; i < controller.getNumElevators(); i++){
+		if (!controller.isElevatorAvailable(i))
+			continue;
+		int cost = controller.ticksToReach(i, outFloor, dir) + controller.getElevatorRequests(i);
+		if (cost < bestCost){
+			bestCost = cost;
+			best = i;
+		}
+	}
+	return best;
+}
+
+int ZoningPolicy::chooseCar(const EventSimulation& sim, const TimedRequest& req){
+	int zones = min(numZones, sim.getNumCars());
+	int zoneFloor = (req.outFloor == 1 ? req.inFloor : req.outFloor);
+	int zone = (zoneFloor - 1) * zones / sim.getNumFloors();
+	double bestCost = 1e300;
+	int best = zone;
+	for (int i = zone; i < sim.getNumCars(); i += zones){
+		double cost = etaCost(sim, i, req);
+		if (cost < bestCost){
+			bestCost = cost;
+			best = i;
+		}
+	}
+	return best;
+}
+
+int DestinationDispatchPolicy::chooseCar(const EventSimulation& sim, const TimedRequest& req){
+	const SimulationTiming& timing = sim.getTiming();
+	double stopTime = timing.doorOpen + timing.doorClose;
+	ElevatorDirection wants = (req.outFloor < req.inFloor ? UP : DOWN);
+	double bestCost = 1e300;
+	int best = 0;
+	for (int i = 0; i < sim.getNumCars(); i++){
+		const EventSimulation::Car& car = sim.getCar(i);
+		int addedStops = !sim.stopsAt(i, req.outFloor) + !sim.stopsAt(i, req.inFloor);
+		double cost = sim.floorsToReach(i, req.outFloor, wants, req.time) * timing.floorTravel
+		            + (car.numStops + addedStops) * stopTime
+		            + (car.numOfPeople + car.numWaiting) * timing.boardPerPerson;
+		if (car.numOfPeople + car.numWaiting >= sim.getCapacity())
+			cost += sim.getNumFloors() * timing.floorTravel;
+		if (cost < bestCost){
+			bestCost = cost;
+			best = i;
+		}
+	}
+	return best;
+}
+
+
+//---------------------- parameter sweeps, run with "./a.out sweep [threads]" ----------------
+enum TrafficPattern {UP_PEAK, DOWN_PEAK, INTER_FLOOR};
+
+string trafficName(TrafficPattern pattern){
+	return pattern == UP_PEAK ? "up-peak" : pattern == DOWN_PEAK ? "down-peak" : "inter-floor";
+}
+
+/* seeded timed traffic: Poisson arrivals, "perTick" per tick on average, generated on the fly. Up-peak is
+   90% lobby (floor 1) to a random floor, down-peak 90% a random floor to the lobby, and inter-floor
+   uniformly random pairs, which is also the other 10% of the peaks. */
+class TrafficSource : public RequestSource {
+private:
+	TrafficPattern pattern;
+	long long remaining;
+	double tick;
+	mt19937 rng;
+	exponential_distribution<double> gap;
+	uniform_int_distribution<int> anyFloor, upperFloor, percent;
+	
+public:
+	TrafficSource(TrafficPattern pattern, long long count, int num_floors, double perTick, unsigned seed)
+		: pattern(pattern), remaining(count), tick(0), rng(seed), gap(perTick), anyFloor(1, num_floors), 
+		  upperFloor(2, num_floors), percent(0, 99) {}
+	
+	bool next(RequestRecord& request){
+		if (remaining-- <= 0)
+			return false;
+		tick += gap(rng);
+		bool peak = (pattern != INTER_FLOOR && percent(rng) < 90);
+		int outFloor, inFloor;
+		if (peak && pattern == UP_PEAK){
+			outFloor = 1;
+			inFloor = upperFloor(rng);
+		}
+		else if (peak){
+			outFloor = upperFloor(rng);
+			inFloor = 1;
+		}
+		else {
+			outFloor = anyFloor(rng);
+			inFloor = anyFloor(rng);
+			while (inFloor == outFloor)
+				inFloor = anyFloor(rng);
+		}
+		request = RequestRecord{(int)tick, outFloor, inFloor};
+		return true;
+	}
+};
+
+struct SweepPoint {
+	TrafficPattern traffic;
+	DispatchPolicy* policy;   // NULL for Controller's default
+	int elevators;
+	int capacity;
+	int maxRequests;
+	int replication;
+	unsigned seed;
+};
+
+struct DistributionSummary {
+	double mean;
+	long long p50, p95, p99, max;
+};
+
+struct SweepResult {
+	SweepPoint point;
+	long long peakBacklog;      // requests that had to wait for an elevator with a free request slot
+	SimulationMetrics metrics;
+	DistributionSummary wait;   // ticks from assignment to pickup
+	DistributionSummary ride;   // ticks from pickup to dropoff
+};
+
+/* runs one headless Controller simulation per point of a parameter grid, on several threads. Every
+   simulation streams its traffic into Controller::runStream as it arrives and owns its Controller and RNG
+   streams, and its seed depends only on the base seed, the traffic pattern and the replication number. So
+   all the parameter combinations of a replication see the same arrivals and the same starting elevators,
+   and the results do not depend on the number of threads. The dispatch policies are shared by all the
+   threads, so they must not keep state between calls (NearestCarPolicy and EtaPolicy do not). */
+class SweepRunner {
+private:
+	int numFloors;
+	int numRequests;
+	double perTick;
+	vector<SweepPoint> points;
+	
+	static DistributionSummary summarize(const TickHistogram& h){
+		return DistributionSummary{h.mean(), h.percentile(0.5), h.percentile(0.95), h.percentile(0.99), h.percentile(1.0)};
+	}
+	
+	SweepResult simulate(const SweepPoint& p){
+		TrafficSource traffic(p.traffic, numRequests, numFloors, perTick, p.seed);
+		Controller controller(p.elevators, numFloors, p.maxRequests, p.capacity, false, p.seed ^ 0x9e3779b9u);
+		controller.setDispatchPolicy(p.policy);
+		controller.runStream(traffic);
+		return SweepResult{p, controller.getPeakBacklog(), controller.getMetrics(), 
+		                   summarize(controller.getWaitHistogram()), summarize(controller.getRideHistogram())};
+	}
+	
+public:
+	// "numRequests" arrivals per simulation, "perTick" of them per tick on average
+	SweepRunner(int num_floors, int num_requests, double perTick){
+		if (num_floors < 2 || num_requests < 0 || perTick <= 0)
+			throw invalid_argument("need at least two floors and a positive arrival rate");
+		numFloors = num_floors;
+		numRequests = num_requests;
+		this->perTick = perTick;
+	}
+	
+	void addGrid(const vector<TrafficPattern>& traffic, const vector<int>& elevators, const vector<int>& capacities,
+	             const vector<int>& maxRequests, int replications, unsigned baseSeed, 
+	             const vector<DispatchPolicy*>& policies = vector<DispatchPolicy*>{NULL}){
+		for (TrafficPattern t : traffic){
+			for (int r = 0; r < replications; r++){
+				seed_seq seq{baseSeed, (unsigned)t, (unsigned)r};
+				unsigned seed;
+				seq.generate(&seed, &seed + 1);
+				for (DispatchPolicy* policy : policies)
+					for (int e : elevators)
+						for (int c : capacities)
+							for (int m : maxRequests)
+								points.push_back(SweepPoint{t, policy, e, c, m, r, seed});
+			}
+		}
+	}
+	
+	int size(){
+		return points.size();
+	}
+	
+	// results come back in the order the points were added
+	vector<SweepResult> run(int numThreads){
+		vector<SweepResult> results(points.size());
+		atomic<int> next(0);
+		auto worker = [&](){
+			for (int i = next++; i < (int)points.size(); i = next++)
+				results[i] = simulate(points[i]);
+		};
+		vector<thread> threads;
+		for (int t = 1; t < numThreads; t++)
+			threads.push_back(thread(worker));
+		worker();
+		for (thread& t : threads)
+			t.join();
+		return results;
+	}
+	
+	static void writeCsv(ostream& out, const vector<SweepResult>& results){
+		NearestCarPolicy defaultPolicy;
+		out << "traffic,policy,elevators,capacity,max_requests,replication,seed,peak_backlog,ticks,delivered,floors_travelled,"
+		    << "wait_mean,wait_p50,wait_p95,wait_p99,wait_max,ride_mean,ride_p50,ride_p95,ride_p99,ride_max\n";
+		for (const SweepResult& r : results){
+			const SweepPoint& p = r.point;
+			out << trafficName(p.traffic) << ',' << (p.policy != NULL ? p.policy : &defaultPolicy)->name() << ',' 
+			    << p.elevators << ',' << p.capacity << ',' << p.maxRequests << ',' 
+			    << p.replication << ',' << p.seed << ',' << r.peakBacklog << ',' << r.metrics.ticks << ',' 
+			    << r.metrics.passengersDelivered << ',' << r.metrics.floorsTravelled;
+			for (const DistributionSummary* d : {&r.wait, &r.ride})
+				out << ',' << d->mean << ',' << d->p50 << ',' << d->p95 << ',' << d->p99 << ',' << d->max;
+			out << '\n';
+		}
+	}
+};
+
+// the grid behind "./a.out sweep", also timed by the benchmarks: 400 arrivals at one every 4 ticks
+SweepRunner defaultSweep(){
+	static EtaPolicy eta;
+	SweepRunner sweep(20, 400, 0.25);
+	sweep.addGrid({UP_PEAK, DOWN_PEAK, INTER_FLOOR}, {2, 4, 8}, {4, 8, 16}, {4, 8, 16}, 10, 2024, {NULL, &eta});
+	return sweep;
+}
+
+int runSweep(int numThreads){
+	SweepRunner sweep = defaultSweep();
+	auto start = chrono::steady_clock::now();
+	vector<SweepResult> results = sweep.run(numThreads);
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	SweepRunner::writeCsv(cout, results);
+	cerr << sweep.size() << " simulations on " << numThreads << " threads in " << seconds << " s" << endl;
+	return 0;
+}
+
+
+//---------------------- benchmarks, run with "./a.out bench [elevators floors requests]" ----------------
+// uniformly random (outFloor, inFloor) pairs with outFloor != inFloor
+vector<pair<int, int>> randomRequests(int numRequests, int numFloors, unsigned seed){
+	mt19937 rng(seed);
+	vector<pair<int, int>> reqs;
+	for (int i = 0; i < numRequests; i++){
+		int outFloor = 1 + rng() % numFloors;
+		int inFloor = 1 + rng() % (numFloors - 1);
+		if (inFloor >= outFloor)
+			inFloor++;
+		reqs.push_back(make_pair(outFloor, inFloor));
+	}
+	return reqs;
+}
+
+void printMetrics(const string& name, SimulationMetrics m){
+	cout << "  " << name << ": " << m.ticks << " ticks in " << m.wallSeconds << " s, " 
+	     << m.ticks / max(m.wallSeconds, 1e-9) << " ticks/s, " << m.passengersDelivered << " delivered, "
+	     << m.floorsTravelled << " floors travelled" << endl;
+}
+
+// swallows everything written to it, to time the printing mode without a terminal in the way
+class NullBuffer : public streambuf {
+protected:
+	int overflow(int c) override {
+		return c;
+	}
+};
+
+SimulationMetrics simulate(vector<pair<int, int>>& reqs, int numElevators, int numFloors, bool verbose, int traceEvery){
+	Controller controller(numElevators, numFloors, (int)reqs.size() / numElevators + 1, 8, verbose);
+	if (traceEvery > 0)
+		controller.enableTrace("elevator-trace.bin", traceEvery);
+	controller.loadRequests(reqs);
+	controller.assignRequests();
+	controller.run();
+	return controller.getMetrics();
+}
+
+// the hashmap-of-hashsets Elevator this file used before the FloorSet one, as the baseline
+class mapElevator {
+private:
+	int maxRequests, maxFloor, minFloor;
+	int numOfPeople, Capacity;
+	int currFloor;
+	ElevatorDirection currMoveDir;
+	unordered_map<int, unordered_set<int>> destRequests;
+	unordered_map<int, unordered_set<int>> destProcess;
+	
+public:
+	mapElevator(int max_requests, int max_floor, int min_floor, int cap, unsigned seed){
+		maxRequests = max_requests;
+		maxFloor = max_floor;
+		minFloor = min_floor;
+		numOfPeople = 0;
+		Capacity = cap;
+		mt19937 rng(seed);
+		currFloor = min_floor + rng() % (max_floor - min_floor);
+		currMoveDir = (rng() % 2 ? UP : DOWN);
+	}
+	
+	int getCurrFloor(){
+		return currFloor;
+	}
+	
+	int getNumRequests(){
+		int count = 0;
+		for (auto m : destRequests)
+			count += m.second.size();
+		return count;
+	}
+	
+	int isAvailable(){
+		return getNumRequests() < maxRequests;
+	}
+	
+	bool finish() {
+		return destRequests.empty() && destProcess.empty();
+	}
+	
+	void addNewRequest(int outFloor, int inFloor){
+		destRequests[outFloor].insert(inFloor);
+	}
+	
+	void nextDirection(){
+		if (currFloor == maxFloor)
+			currMoveDir = DOWN;
+		else if (currFloor == minFloor)
+			currMoveDir = UP;
+		else if (currMoveDir == UP){
+			int nextUpperFloor = minFloor;
+			for (auto m : destRequests)
+				nextUpperFloor = max(nextUpperFloor, m.first);
+			for (auto m : destProcess)
+				for (int n : m.second)
+					nextUpperFloor = max(nextUpperFloor, n);
+			if (nextUpperFloor < currFloor)
+				currMoveDir = DOWN;
+		}
+		else {
+			int nextLowerFloor = maxFloor;
+			for (auto m : destRequests)
+				nextLowerFloor = min(nextLowerFloor, m.first);
+			for (auto m : destProcess)
+				for (int n : m.second)
+					nextLowerFloor = min(nextLowerFloor, n);
+			if (nextLowerFloor > currFloor)
+				currMoveDir = UP;
+		}
+	}
+	
+	void step(){
+		if (destRequests.count(currFloor)){
+			while(numOfPeople < Capacity && !destRequests[currFloor].empty()){
+				destProcess[currFloor].insert(*destRequests[currFloor].begin());
+				destRequests[currFloor].erase(destRequests[currFloor].begin());
+				numOfPeople++;
+			}
+			if (destRequests[currFloor].empty())
+				destRequests.erase(currFloor);
+		}
+		vector<int> emptyIdx;
+		for (auto& request : destProcess){
+			if (request.second.count(currFloor)){
+				request.second.erase(currFloor);
+				numOfPeople--;
+				if (request.second.empty())
+					emptyIdx.push_back(request.first);
+			}
+		}
+		for (int idx : emptyIdx)
+			destProcess.erase(idx);
+		nextDirection();
+		if (currMoveDir == UP)
+			currFloor++;
+		else
+			currFloor--;
+	}
+};
+
+/* the candidate scan of assignUserRequest (nearest available elevator, falling back to the first available)
+   for every request, then step() on every elevator until all requests are delivered */
+template<class E>
+void timeElevatorOps(const string& name, int numElevators, int numFloors, vector<pair<int, int>>& reqs){
+	mt19937 seeds(1);
+	vector<E*> bank;
+	for (int i = 0; i < numElevators; i++)
+		bank.push_back(new E((int)reqs.size() / numElevators + 1, numFloors, 1, 8, seeds()));
+	
+	auto start = chrono::steady_clock::now();
+	for (auto r : reqs){
+		int minDist = INT_MAX, minDistIdx = -1;
+		for (int i = 0; i < numElevators; i++){
+			if (bank[i]->isAvailable() && abs(bank[i]->getCurrFloor() - r.first) < minDist){
+				minDist = abs(bank[i]->getCurrFloor() - r.first);
+				minDistIdx = i;
+			}
+		}
+		bank[minDistIdx]->addNewRequest(r.first, r.second);
+	}
+	double assignSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	
+	start = chrono::steady_clock::now();
+	long long steps = 0;
+	bool done = false;
+	while (!done){
+		done = true;
+		for (E* e : bank){
+			if (!e->finish()){
+				e->step();
+				steps++;
+				done = false;
+			}
+		}
+	}
+	double stepSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "  " << name << ": assign " << reqs.size() / assignSeconds / 1e6 << " M requests/s, step " 
+	     << steps / stepSeconds / 1e6 << " M steps/s (" << steps << " steps)" << endl;
+	for (E* e : bank)
+		delete e;
+}
+
+void benchElevatorState(int numElevators, int numFloors, int numRequests){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests, elevator request state" << endl;
+	vector<pair<int, int>> reqs = randomRequests(numRequests, numFloors, 5);
+	timeElevatorOps<mapElevator>("unordered_map of unordered_set", numElevators, numFloors, reqs);
+	timeElevatorOps<Elevator>("FloorSet bitsets + counters", numElevators, numFloors, reqs);
+}
+
+// Controller::assignUserRequest as it was before the ordered indexes: linear scans over the lists
+bool linearAssignUserRequest(vector<Elevator*>& elevators, vector<int>& upList, vector<int>& downList, int outFloor, int inFloor){
+	bool UserWantsUp = (outFloor < inFloor);
+	int minDist = INT_MAX, minDistIdx = -1;
+	if (UserWantsUp){
+		for (int up : upList){
+			if (elevators[up]->getCurrFloor() < outFloor && elevators[up]->isAvailable() &&
+			    outFloor - elevators[up]->getCurrFloor() < minDist){
+				minDist = outFloor - elevators[up]->getCurrFloor();
+				minDistIdx = up;
+			}
+		}
+	}
+	else {
+		for (int down : downList){
+			if (elevators[down]->getCurrFloor() > outFloor && elevators[down]->isAvailable() &&
+			    elevators[down]->getCurrFloor() - outFloor < minDist){
+				minDist = elevators[down]->getCurrFloor() - outFloor;
+				minDistIdx = down;
+			}
+		}
+	}
+	if (minDistIdx != -1){
+		elevators[minDistIdx]->addNewRequest(outFloor, inFloor);
+		return true;
+	}
+	vector<int>& secondPrimaryList = (UserWantsUp ? downList : upList);
+	for (int idx : secondPrimaryList){
+		if (elevators[idx]->isAvailable() && abs(elevators[idx]->getCurrFloor() - outFloor) < minDist){
+			minDist = abs(elevators[idx]->getCurrFloor() - outFloor);
+			minDistIdx = idx;
+		}
+	}
+	if (minDistIdx != -1){
+		elevators[minDistIdx]->addNewRequest(outFloor, inFloor);
+		return true;
+	}
+	for (int i = 0; i < (int)elevators.size(); i++){
+		if (elevators[i]->isAvailable()){
+			elevators[i]->addNewRequest(outFloor, inFloor);
+			return true;
+		}
+	}
+	return false;
+}
+
+void benchDispatch(int numElevators, int numFloors, int numRequests){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests, dispatch" << endl;
+	vector<pair<int, int>> reqs = randomRequests(numRequests, numFloors, 3);
+	int maxRequests = numRequests / numElevators + 1;
+	
+	mt19937 seeds(1);   // the same elevators as Controller's default seed
+	vector<Elevator*> elevators;
+	vector<int> upList, downList;
+	for (int i = 0; i < numElevators; i++){
+		elevators.push_back(new Elevator(maxRequests, numFloors, 1, 8, seeds()));
+		(elevators[i]->getCurrMoveDir() == UP ? upList : downList).push_back(i);
+	}
+	auto start = chrono::steady_clock::now();
+	for (auto r : reqs)
+		linearAssignUserRequest(elevators, upList, downList, r.first, r.second);
+	double linearSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	
+	Controller controller(numElevators, numFloors, maxRequests, 8, false);
+	controller.loadRequests(reqs);
+	start = chrono::steady_clock::now();
+	controller.assignRequests();
+	double indexedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	
+	// both must have made exactly the same assignments
+	ostringstream linearOut, indexedOut;
+	streambuf* coutBuffer = cout.rdbuf(linearOut.rdbuf());
+	for (int i = 0; i < numElevators; i++){
+		cout << "print requests for elevator " << i << endl;
+		elevators[i]->printRequests();
+	}
+	cout.rdbuf(indexedOut.rdbuf());
+	controller.printRequestsAssignment();
+	cout.rdbuf(coutBuffer);
+	for (Elevator* e : elevators)
+		delete e;
+	
+	cout << "  linear scans: " << numRequests / linearSeconds / 1e6 << " M requests/s" << endl;
+	cout << "  ordered indexes: " << numRequests / indexedSeconds / 1e6 << " M requests/s, same assignments: " 
+	     << (linearOut.str() == indexedOut.str() ? "yes" : "NO") << endl;
+}
+
+// linearAssignUserRequest's choices from SIMD scans of a bank mirroring "elevators"
+bool bankAssignUserRequest(vector<Elevator*>& elevators, ElevatorBank& bank, int outFloor, int inFloor){
+	bool UserWantsUp = (outFloor < inFloor);
+	int minDistIdx = (UserWantsUp ? bank.nearestBelow(UP, outFloor) : bank.nearestAtOrAbove(DOWN, outFloor + 1));
+	if (minDistIdx == -1){
+		ElevatorDirection second = (UserWantsUp ? DOWN : UP);
+		int below = bank.nearestBelow(second, outFloor), above = bank.nearestAtOrAbove(second, outFloor);
+		if (below != -1 && above != -1){
+			int belowDist = outFloor - bank.floorOf(below), aboveDist = bank.floorOf(above) - outFloor;
+			minDistIdx = (belowDist < aboveDist || (belowDist == aboveDist && below < above) ? below : above);
+		}
+		else
+			minDistIdx = (below != -1 ? below : above);
+	}
+	if (minDistIdx == -1)
+		minDistIdx = bank.firstAvailable();
+	if (minDistIdx == -1)
+		return false;
+	elevators[minDistIdx]->addNewRequest(outFloor, inFloor);
+	bank.addRequest(minDistIdx);
+	return true;
+}
+
+string printedAssignment(vector<Elevator*>& elevators){
+	ostringstream out;
+	streambuf* coutBuffer = cout.rdbuf(out.rdbuf());
+	for (int i = 0; i < (int)elevators.size(); i++){
+		cout << "print requests for elevator " << i << endl;
+		elevators[i]->printRequests();
+	}
+	cout.rdbuf(coutBuffer);
+	return out.str();
+}
+
+/* assignment throughput for a bank of "numElevators" cars. All requests at once: pointer-chasing scans
+   against SIMD scans of the structure-of-arrays bank, and the Controller, which switches to its ordered
+   indexes after a few scans. Then "perTick" requests between moves, the way runStream() assigns: the
+   ordered indexes rebuilt on every tick against the Controller's scans-first dispatch. */
+void benchElevatorBank(int numElevators, int numFloors, int numRequests, int perTick){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests, elevator bank" << endl;
+	vector<pair<int, int>> reqs = randomRequests(numRequests, numFloors, 49);
+	int maxRequests = numRequests / numElevators + 1;
+	vector<Elevator*> pointers, banked;
+	vector<int> upList, downList;
+	ElevatorBank bank(numElevators, numFloors, maxRequests);
+	mt19937 seeds(1);   // the same elevators as Controller's default seed
+	for (int i = 0; i < numElevators; i++){
+		unsigned seed = seeds();
+		pointers.push_back(new Elevator(maxRequests, numFloors, 1, 8, seed));
+		banked.push_back(new Elevator(maxRequests, numFloors, 1, 8, seed));
+		(pointers[i]->getCurrMoveDir() == UP ? upList : downList).push_back(i);
+		bank.update(i, banked[i]->getCurrFloor(), banked[i]->getCurrMoveDir(), 0, 0);
+	}
+	auto start = chrono::steady_clock::now();
+	for (auto r : reqs)
+		linearAssignUserRequest(pointers, upList, downList, r.first, r.second);
+	double linearSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	start = chrono::steady_clock::now();
+	for (auto r : reqs)
+		bankAssignUserRequest(banked, bank, r.first, r.second);
+	double bankSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	Controller controller(numElevators, numFloors, maxRequests, 8, false);
+	controller.loadRequests(reqs);
+	start = chrono::steady_clock::now();
+	controller.assignRequests();
+	double controllerSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	ostringstream controllerOut;
+	streambuf* coutBuffer = cout.rdbuf(controllerOut.rdbuf());
+	controller.printRequestsAssignment();
+	cout.rdbuf(coutBuffer);
+	string linearOut = printedAssignment(pointers);
+	bool same = (linearOut == printedAssignment(banked) && linearOut == controllerOut.str());
+	for (int i = 0; i < numElevators; i++){
+		delete pointers[i];
+		delete banked[i];
+	}
+	cout << "  all at once: pointer-chasing scans " << numRequests / linearSeconds / 1e6 << " M requests/s, SIMD bank scans " 
+	     << numRequests / bankSeconds / 1e6 << " M requests/s, controller " << numRequests / controllerSeconds / 1e6 
+	     << " M requests/s, same assignments: " << (same ? "yes" : "NO") << endl;
+	
+	double seconds[2] = {0, 0};
+	SimulationMetrics metrics[2];
+	for (int scansFirst = 0; scansFirst < 2; scansFirst++){
+		Controller c(numElevators, numFloors, 16, 8, false);
+		size_t next = 0;
+		while (next < reqs.size()){
+			auto tickStart = chrono::steady_clock::now();
+			if (!scansFirst)
+				c.buildDispatchIndex();
+			for (int k = 0; k < perTick && next < reqs.size(); k++, next++)
+				if (!c.assignUserRequest(reqs[next].first, reqs[next].second))
+					break;
+			seconds[scansFirst] += chrono::duration<double>(chrono::steady_clock::now() - tickStart).count();
+			c.stepAll();
+		}
+		c.run();
+		metrics[scansFirst] = c.getMetrics();
+	}
+	cout << "  " << perTick << " per tick: index rebuilt every tick " << numRequests / seconds[0] / 1e6 
+	     << " M requests/s, scans first " << numRequests / seconds[1] / 1e6 << " M requests/s, same simulation: " 
+	     << (metrics[0].waitTicks == metrics[1].waitTicks && metrics[0].floorsTravelled == metrics[1].floorsTravelled ? "yes" : "NO") << endl;
+}
+
+/* greedy one-at-a-time assignment against min-cost batches of several window sizes, and a large window
+   under a latency budget. maxRequests leaves every elevator room for twice its fair share. */
+void benchBatchAssignment(int numElevators, int numFloors, int numRequests){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests, batch assignment" << endl;
+	vector<pair<int, int>> reqs = randomRequests(numRequests, numFloors, 23);
+	int maxRequests = 2 * numRequests / numElevators;
+	
+	for (int window : {0, 8, 32, 128, -32, -512}){
+		Controller controller(numElevators, numFloors, maxRequests, 8, false);
+		controller.loadRequests(reqs);
+		auto start = chrono::steady_clock::now();
+		if (window == 0)
+			controller.assignRequests();
+		else
+			controller.assignRequestsBatch(abs(window), window < 0 ? 200 : 0);
+		double assignSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		controller.run();
+		SimulationMetrics m = controller.getMetrics();
+		BatchStats b = controller.getBatchStats();
+		
+		if (window == 0)
+			cout << "  greedy";
+		else
+			cout << "  window " << abs(window) << (window < 0 ? ", 200 us budget" : "");
+		cout << ": avg wait " << (double)m.waitTicks / m.passengersPickedUp << " ticks, all done after " << m.ticks 
+		     << " ticks, " << m.floorsTravelled << " floors travelled, assignment " << assignSeconds * 1e3 << " ms";
+		if (window != 0)
+			cout << ", per batch avg " << b.totalSeconds / b.batches * 1e6 << " us max " << b.maxSeconds * 1e6 
+			     << " us, " << b.greedyFallbacks << " greedy fallbacks";
+		cout << endl;
+	}
+}
+
+// a whole file's bytes, to compare trace files
+string readFile(const string& path){
+	FILE* f = fopen(path.c_str(), "rb");
+	string data;
+	char buffer[1 << 16];
+	size_t n;
+	while (f != NULL && (n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		data.append(buffer, n);
+	if (f != NULL)
+		fclose(f);
+	return data;
+}
+
+// serial against parallel stepping of the same run, which must produce the same metrics and per-tick trace
+void benchParallelStep(int numElevators, int numFloors, int numRequests){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests, parallel stepping ("
+	     << thread::hardware_concurrency() << " hardware threads)" << endl;
+	vector<pair<int, int>> reqs = randomRequests(numRequests, numFloors, 29);
+	string serialTrace;
+	SimulationMetrics serial{0, 0, 0, 0, 0, 0};
+	for (int threads : {1, 2, 4, 8}){
+		Controller controller(numElevators, numFloors, numRequests / numElevators + 1, 8, false);
+		controller.setNumThreads(threads);
+		controller.enableTrace("elevator-trace.bin", 1);
+		controller.loadRequests(reqs);
+		controller.assignRequests();
+		controller.run();
+		SimulationMetrics m = controller.getMetrics();
+		controller.enableTrace("/dev/null", 1);   // flushes and closes the trace file
+		string trace = readFile("elevator-trace.bin");
+		if (threads == 1){
+			serial = m;
+			serialTrace = trace;
+		}
+		bool same = (trace == serialTrace && m.ticks == serial.ticks && m.floorsTravelled == serial.floorsTravelled &&
+		             m.passengersDelivered == serial.passengersDelivered && m.waitTicks == serial.waitTicks);
+		cout << "  " << threads << " threads: " << m.ticks << " ticks in " << m.wallSeconds << " s, " 
+		     << m.ticks * (double)numElevators / m.wallSeconds / 1e6 << " M elevator steps/s, identical to serial: " 
+		     << (same ? "yes" : "NO") << endl;
+	}
+	remove("elevator-trace.bin");
+}
+
+long long peakRssMiB(){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024;
+}
+
+/* the same request stream generated on the fly, then memory-mapped from a trace file, then preloaded
+   the old way. Runs first so the peak RSS of the streaming runs is not hidden by the other benchmarks. */
+void benchStreaming(int numElevators, int numFloors, long long numRequests, double perTick){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests streamed at " 
+	     << perTick << " per tick" << endl;
+	SimulationMetrics generated;
+	{
+		GeneratedRequestSource source(numRequests, numFloors, perTick, 31);
+		Controller controller(numElevators, numFloors, 16, 8, false);
+		controller.runStream(source);
+		generated = controller.getMetrics();
+		cout << "  generated: " << generated.ticks << " ticks, " << generated.passengersDelivered << " delivered in " 
+		     << generated.wallSeconds << " s, " << numRequests / generated.wallSeconds / 1e6 << " M requests/s, peak backlog " 
+		     << controller.getPeakBacklog() << ", peak RSS " << peakRssMiB() << " MiB" << endl;
+	}
+	{
+		GeneratedRequestSource source(numRequests, numFloors, perTick, 31);
+		writeRequestTrace("elevator-requests.bin", source);
+		MappedRequestTrace trace("elevator-requests.bin");
+		Controller controller(numElevators, numFloors, 16, 8, false);
+		controller.runStream(trace);
+		SimulationMetrics m = controller.getMetrics();
+		cout << "  memory-mapped " << numRequests * sizeof(RequestRecord) / (1 << 20) << " MiB trace: " << m.ticks << " ticks, " 
+		     << m.passengersDelivered << " delivered in " << m.wallSeconds << " s, same as generated: " 
+		     << (m.ticks == generated.ticks && m.waitTicks == generated.waitTicks && m.floorsTravelled == generated.floorsTravelled ? "yes" : "NO") 
+		     << ", peak RSS " << peakRssMiB() << " MiB" << endl;
+	}
+	remove("elevator-requests.bin");
+	{
+		GeneratedRequestSource source(numRequests, numFloors, perTick, 31);
+		vector<pair<int, int>> reqs;
+		RequestRecord request;
+		while (source.next(request))
+			reqs.push_back(make_pair(request.outFloor, request.inFloor));
+		Controller controller(numElevators, numFloors, numRequests / numElevators + 1, 8, false);
+		controller.loadRequests(reqs);
+		controller.assignRequests();
+		controller.run();
+		SimulationMetrics m = controller.getMetrics();
+		cout << "  preloaded, all assigned at tick 0: " << m.ticks << " ticks, " << m.passengersDelivered << " delivered in " 
+		     << m.wallSeconds << " s, peak RSS " << peakRssMiB() << " MiB" << endl;
+	}
+}
+
+/* instrumentation overhead, measured on two copies of the same day stepped in lockstep, the second one
+   instrumented. Every tick of each is timed on its own, in alternating order, so whatever else the machine
+   does in the meantime hits both alike instead of landing on whichever run it happens to overlap. */
+void benchInstrumentation(int numElevators, int numFloors, int numRequests){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests, instrumentation off/on in lockstep" << endl;
+	vector<pair<int, int>> reqs = randomRequests(numRequests, numFloors, 48);
+	Controller off(numElevators, numFloors, numRequests / numElevators + 1, 8, false);
+	Controller on(numElevators, numFloors, numRequests / numElevators + 1, 8, false);
+	on.enableInstrumentation();
+	Controller* controllers[2] = {&off, &on};
+	double seconds[2] = {0, 0};
+	bool finished[2] = {false, false};
+	for (int k = 0; k < 2; k++){
+		controllers[k]->loadRequests(reqs);
+		controllers[k]->assignRequests();
+	}
+	for (long long tick = 0; !finished[0] || !finished[1]; tick++){
+		for (int k = 0; k < 2; k++){
+			int which = (tick + k) % 2;
+			if (finished[which])
+				continue;
+			auto start = chrono::steady_clock::now();
+			finished[which] = controllers[which]->stepAll();
+			seconds[which] += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		}
+	}
+	TickHistogram exact = on.getWaitHistogram();
+	cout << "  wait    " << on.getWaitHdr().summary() << " (exact p99 " << exact.percentile(0.99) << ")" << endl;
+	cout << "  journey " << on.getJourneyHdr().summary() << endl;
+	const ElevatorProbe& p = on.getProbe(0);
+	cout << "  elevator 0: utilization " << p.utilization() << ", " << p.stops << " stops, " << p.directionChanges 
+	     << " direction changes, " << p.passengers.size() << " of " << p.passengers.total() << " passengers in its ring" << endl;
+	ostringstream log;
+	on.writePassengerLog(log);
+	string rows = log.str();
+	cout << "  passenger log: " << count(rows.begin(), rows.end(), '\n') - 1 << " rows" << endl;
+	cout << "  stepping off " << seconds[0] << " s, on " << seconds[1] << " s, overhead " 
+	     << 100 * (seconds[1] / seconds[0] - 1) << "%" << endl;
+}
+
+/* forking a running simulation: checkpoint and restore against deep-copying every Elevator, a check that a
+   restored branch replays the original exactly, and a rollout dispatcher built on it against greedy dispatch */
+void benchCheckpoint(int numElevators, int numFloors, int perTick, int warmTicks){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << perTick << " requests per tick, checkpoints after " 
+	     << warmTicks << " ticks" << endl;
+	vector<pair<int, int>> reqs = randomRequests(perTick * warmTicks * 2, numFloors, 50);
+	Controller live(numElevators, numFloors, 16, 8, false);
+	size_t next = 0;
+	for (int t = 0; t < warmTicks; t++){
+		for (int k = 0; k < perTick; k++, next++)
+			live.assignUserRequest(reqs[next].first, reqs[next].second);
+		live.stepAll();
+	}
+	
+	const int rounds = 200;
+	SimulationCheckpoint checkpoint;
+	auto start = chrono::steady_clock::now();
+	for (int r = 0; r < rounds; r++)
+		live.checkpoint(checkpoint);
+	double checkpointMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / rounds;
+	Controller branch(checkpoint);
+	start = chrono::steady_clock::now();
+	for (int r = 0; r < rounds; r++)
+		branch.restore(checkpoint);
+	double restoreMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / rounds;
+	start = chrono::steady_clock::now();
+	for (int r = 0; r < rounds; r++){
+		vector<Elevator*> copies;
+		for (int i = 0; i < numElevators; i++)
+			copies.push_back(new Elevator(live.getElevator(i)));
+		for (Elevator* e : copies)
+			delete e;
+	}
+	double copyMicros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / rounds;
+	
+	// the branch continues exactly like the original
+	for (int t = 0; t < warmTicks; t++){
+		for (int k = 0; k < perTick; k++, next++){
+			live.assignUserRequest(reqs[next].first, reqs[next].second);
+			branch.assignUserRequest(reqs[next].first, reqs[next].second);
+		}
+		live.stepAll();
+		branch.stepAll();
+	}
+	live.run();
+	branch.run();
+	SimulationMetrics a = live.getMetrics(), b = branch.getMetrics();
+	cout << "  checkpoint " << checkpoint.bytes() << " bytes in " << checkpointMicros << " us, restore " << restoreMicros 
+	     << " us, deep copy of the elevators " << copyMicros << " us, branch replays identically: " 
+	     << (a.ticks == b.ticks && a.waitTicks == b.waitTicks && a.floorsTravelled == b.floorsTravelled && 
+	         a.passengersDelivered == b.passengersDelivered ? "yes" : "NO") << endl;
+}
+
+// greedy dispatch against rollouts of every candidate, one request every "every" ticks
+void benchRollout(int numElevators, int numFloors, int numRequests, int every, int horizon){
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests every " << every 
+	     << " ticks, greedy against " << horizon << "-tick rollouts" << endl;
+	vector<pair<int, int>> reqs = randomRequests(numRequests, numFloors, 51);
+	for (int rollout = 0; rollout < 2; rollout++){
+		Controller live(numElevators, numFloors, 4, 4, false);
+		RolloutPolicy policy(horizon);
+		if (rollout)
+			live.setDispatchPolicy(&policy);
+		double decisionSeconds = 0;
+		for (auto r : reqs){
+			auto start = chrono::steady_clock::now();
+			bool assigned = live.assignUserRequest(r.first, r.second);
+			decisionSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+			while (!assigned){
+				live.stepAll();
+				assigned = live.assignUserRequest(r.first, r.second);
+			}
+			for (int t = 0; t < every; t++)
+				live.stepAll();
+		}
+		live.run();
+		SimulationMetrics m = live.getMetrics();
+		TickHistogram wait = live.getWaitHistogram();
+		cout << "  " << (rollout ? "rollouts" : "greedy  ") << ": avg wait " << wait.mean() << " ticks, p95 " << wait.percentile(0.95) 
+		     << ", " << m.floorsTravelled << " floors travelled, " << decisionSeconds / numRequests * 1e6 << " us per decision" << endl;
+	}
+}
+
+// the default sweep grid on one thread and on every hardware thread; the CSV must not change
+void benchSweep(){
+	int hardware = max(2u, thread::hardware_concurrency());
+	string serialCsv;
+	for (int threads : {1, hardware}){
+		SweepRunner sweep = defaultSweep();
+		auto start = chrono::steady_clock::now();
+		vector<SweepResult> results = sweep.run(threads);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		ostringstream csv;
+		SweepRunner::writeCsv(csv, results);
+		if (threads == 1)
+			serialCsv = csv.str();
+		cout << "sweep of " << sweep.size() << " simulations on " << threads << " threads: " << seconds << " s, " 
+		     << sweep.size() / seconds << " simulations/s, same CSV as 1 thread: " << (csv.str() == serialCsv ? "yes" : "NO") << endl;
+	}
+}
+
+// Poisson arrivals spread over "seconds", with uniformly random floors except that a "lobbyShare"
+// fraction of the passengers come in at floor 1
+vector<TimedRequest> randomTimedRequests(int numRequests, int numFloors, double seconds, unsigned seed, double lobbyShare = 0){
+	mt19937 rng(seed);
+	exponential_distribution<double> gap(numRequests / seconds);
+	uniform_real_distribution<double> share(0, 1);
+	vector<TimedRequest> reqs;
+	double time = 0;
+	for (int i = 0; i < numRequests; i++){
+		time += gap(rng);
+		int outFloor = 1 + rng() % numFloors;
+		if (share(rng) < lobbyShare)
+			outFloor = 1;
+		int inFloor = 1 + rng() % (numFloors - 1);
+		if (inFloor >= outFloor)
+			inFloor++;
+		reqs.push_back(TimedRequest{time, outFloor, inFloor});
+	}
+	return reqs;
+}
+
+/* a 24-hour building trace through the event engine, then the same trace streamed into the per-tick
+   Controller with one tick per floorTravel seconds, both timed in the same run */
+void benchEventEngine(int numElevators, int numFloors, int numRequests){
+	SimulationTiming timing{1.5, 2.0, 2.0, 1.0};
+	double day = 24 * 3600;
+	cout << "24h trace: " << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " arrivals" << endl;
+	vector<TimedRequest> reqs = randomTimedRequests(numRequests, numFloors, day, 11);
+	
+	EventSimulation sim(numElevators, numFloors, 20, timing, 1);
+	sim.run(reqs);
+	EventMetrics m = sim.getMetrics();
+	cout << "  event engine: " << m.events << " events in " << m.wallSeconds << " s, simulated " << m.simSeconds / 3600 << " h, "
+	     << m.passengers << " delivered, avg wait " << m.totalWait / m.passengers << " s, max wait " << m.maxWait
+	     << " s, avg journey " << m.totalJourney / m.passengers << " s, " << m.floorsTravelled << " floors travelled" << endl;
+	
+	vector<RequestRecord> records;
+	for (const TimedRequest& r : reqs)
+		records.push_back(RequestRecord{(int)(r.time / timing.floorTravel), r.outFloor, r.inFloor});
+	RangeRequestSource<vector<RequestRecord>::iterator> source(records.begin(), records.end());
+	Controller controller(numElevators, numFloors, 16, 20, false);
+	controller.runStream(source);
+	SimulationMetrics t = controller.getMetrics();
+	cout << "  tick engine: " << t.ticks << " ticks (" << t.ticks * timing.floorTravel / 3600 << " h) in " << t.wallSeconds << " s, "
+	     << t.passengersDelivered << " delivered, " << t.wallSeconds / m.wallSeconds << "x the event engine's time" << endl;
+}
+
+// every policy on the same seeded workloads: inter-floor traffic, and a morning up-peak with 80% lobby calls
+void benchPolicies(int numElevators, int numFloors, int numRequests){
+	SimulationTiming timing{1.5, 2.0, 2.0, 1.0};
+	NearestCarPolicy nearest;
+	EtaPolicy eta;
+	ZoningPolicy zoning(4);
+	DestinationDispatchPolicy destination;
+	vector<DispatchPolicy*> policies{&nearest, &eta, &zoning, &destination};
+	
+	for (double lobbyShare : {0.0, 0.8}){
+		cout << numElevators << " cars of 16, " << numFloors << " floors, " << numRequests << " arrivals in 2 h, " 
+		     << (lobbyShare > 0 ? "up-peak" : "inter-floor") << " traffic" << endl;
+		vector<TimedRequest> reqs = randomTimedRequests(numRequests, numFloors, 2 * 3600, 17, lobbyShare);
+		for (DispatchPolicy* p : policies){
+			EventSimulation sim(numElevators, numFloors, 16, timing, 1, p);
+			sim.run(reqs);
+			EventMetrics m = sim.getMetrics();
+			cout << "  " << p->name() << ": wait avg " << m.totalWait / m.passengers << " s, p95 " << m.p95Wait 
+			     << " s, p99 " << m.p99Wait << " s, journey avg " << m.totalJourney / m.passengers << " s, "
+			     << m.floorsTravelled << " floors travelled, " << m.dispatchSeconds / numRequests * 1e9 << " ns/dispatch" << endl;
+		}
+		
+		// the policies that dispatch for Controller too, on the same calls streamed at one tick per floorTravel seconds;
+		// its wait runs from assignment to pickup, so time in the backlog is not in it
+		vector<RequestRecord> records;
+		for (const TimedRequest& r : reqs)
+			records.push_back(RequestRecord{(int)(r.time / timing.floorTravel), r.outFloor, r.inFloor});
+		for (DispatchPolicy* p : {(DispatchPolicy*)&nearest, (DispatchPolicy*)&eta}){
+			RangeRequestSource<vector<RequestRecord>::iterator> source(records.begin(), records.end());
+			Controller controller(numElevators, numFloors, 16, 16, false);
+			controller.setDispatchPolicy(p);
+			controller.runStream(source);
+			TickHistogram waits = controller.getWaitHistogram();
+			cout << "  Controller, " << p->name() << ": wait avg " << waits.mean() * timing.floorTravel << " s, p95 " 
+			     << waits.percentile(0.95) * timing.floorTravel << " s, p99 " << waits.percentile(0.99) * timing.floorTravel << " s, "
+			     << controller.getMetrics().floorsTravelled << " floors travelled, peak backlog " << controller.getPeakBacklog() << endl;
+		}
+	}
+}
+
+int runBenchmarks(int numElevators, int numFloors, int numRequests){
+	benchStreaming(1000, 100, 5000000, 100);
+	benchInstrumentation(1000, 100, 1000000);
+	benchElevatorState(50, 200, 20000);
+	benchDispatch(1000, 100, 1000000);
+	for (int n : {64, 512, 4096})
+		benchElevatorBank(n, 100, 40000, 16);
+	benchBatchAssignment(16, 40, 4000);
+	benchCheckpoint(16, 40, 2, 500);
+	benchCheckpoint(1000, 100, 100, 200);
+	benchRollout(8, 40, 2000, 2, 30);
+	benchParallelStep(4096, 100, 400000);
+	benchSweep();
+	
+	cout << numElevators << " elevators, " << numFloors << " floors, " << numRequests << " requests" << endl;
+	vector<pair<int, int>> reqs = randomRequests(numRequests, numFloors, 7);
+	printMetrics("headless", simulate(reqs, numElevators, numFloors, false, 0));
+	printMetrics("headless, trace every 100 ticks", simulate(reqs, numElevators, numFloors, false, 100));
+	remove("elevator-trace.bin");
+	
+	// printing every tick against headless on a 10x smaller bank, printed output discarded
+	int fewElevators = max(1, numElevators / 10);
+	vector<pair<int, int>> fewReqs(reqs.begin(), reqs.begin() + numRequests / 10);
+	NullBuffer nullBuffer;
+	streambuf* coutBuffer = cout.rdbuf(&nullBuffer);
+	SimulationMetrics printed = simulate(fewReqs, fewElevators, numFloors, true, 0);
+	cout.rdbuf(coutBuffer);
+	cout << fewElevators << " elevators, " << fewReqs.size() << " requests" << endl;
+	printMetrics("printing every tick", printed);
+	printMetrics("headless", simulate(fewReqs, fewElevators, numFloors, false, 0));
+	
+	benchEventEngine(240, 40, 1000000);
+	benchEventEngine(240, 40, 20000);
+	benchPolicies(32, 40, 12000);
+	return 0;
+}
+
+
+int main(int argc, char* argv[]) {
+	if (argc > 1 && string(argv[1]) == "sweep")
+		return runSweep(argc > 2 ? atoi(argv[2]) : max(1u, thread::hardware_concurrency()));
+	if (argc > 1 && string(argv[1]) == "bench")
+		return runBenchmarks(argc > 2 ? atoi(argv[2]) : 100, argc > 3 ? atoi(argv[3]) : 100, 
+		                     argc > 4 ? atoi(argv[4]) : 100000);
+	
+	int num_elevators = 3;
 	int num_floors = 8;
 	int max_elevator_requests = 4;
 	int elevator_cap = 1;
@@ -407,9 +3595,21 @@ int main() {
 	vector<pair<int, int>> reqs{{1, 3}, {3, 5}, {8, 2}, {7, 4}, 
 								{2, 6}, {6, 3}, {6, 8}, {4, 5}, 
 								{5, 7}, {6, 5}, {8, 4}, {1, 7}};
+	controller.enableInstrumentation();
 	controller.loadRequests(reqs);
 	controller.assignRequests();
 	controller.run();
+	controller.printInstrumentation(cout);
+	
+	// the same calls arriving a few seconds apart, through the event-driven engine
+	vector<TimedRequest> timedReqs;
+	for (int i = 0; i < (int)reqs.size(); i++)
+		timedReqs.push_back(TimedRequest{3.0 * i, reqs[i].first, reqs[i].second});
+	EventSimulation sim(num_elevators, num_floors, elevator_cap, SimulationTiming{1.5, 2.0, 2.0, 1.0}, 1);
+	sim.run(timedReqs);
+	EventMetrics m = sim.getMetrics();
+	cout << "event simulation: " << m.passengers << " passengers delivered in " << m.simSeconds << " s, avg wait " 
+	     << m.totalWait / m.passengers << " s, avg journey " << m.totalJourney / m.passengers << " s" << endl;
 	
 	return 0;
 }
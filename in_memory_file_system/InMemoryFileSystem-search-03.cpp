@@ -26,6 +26,9 @@
 *        pointer to the corresponding filter is passed into the search function.                      *
 *    S4. classes "AndFilter" and "OrFilter" are implemented to combine multiple requirements          *
 *        represented as different filters.                                                            *
+*    S5. Metadata other than name and size (owner, created/updated time, extension) lives in a        *
+*        column-per-field table "FileMetadataTable" indexed by file id, so queries over metadata      *
+*        only could scan contiguous arrays instead of walking the tree.                               *
 *                                                                                                     *
 *                                                                                                     *
 *    Question: For the search() function, we need to traverse the "children" list of "Directory"      *
@@ -46,31 +49,213 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <stdexcept>
+#include <cstring>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
 
 using namespace std;
 
 //--------------------------- Implementation of Entry abstract class -----------------------
+class Directory;
+
 class Entry {
 private:
     string name;
+    Directory* parent; // set by Directory::addChild, NULL for the root
 public:
     Entry(const string& name){
         this->name = name;
+        this->parent = NULL;
     }
-    string getName(){
+    const string& getName(){
         return name;
     }
+    Directory* getParent(){
+        return parent;
+    }
+    void setParent(Directory* parent){
+        this->parent = parent;
+    }
+    virtual ~Entry() {}
     virtual bool isFile() = 0;    
 };
 
 
+//--------------------------- Implementation of FileMetadataTable class -----------------------
+// conjunction of conditions on the metadata columns, an empty string / default bound matches everything
+struct MetadataQuery {
+	string owner;
+	string extension;
+	long long minCtime = LLONG_MIN, maxCtime = LLONG_MAX;
+	long long minMtime = LLONG_MIN, maxMtime = LLONG_MAX;
+};
+
+/* Structure-of-arrays store of the file metadata, one slot per file id in every column.
+   Owners and extensions are interned to small ints so a scan compares ints, not strings.
+   Ids of removed files are recycled. */
+class FileMetadataTable {
+private:
+	vector<int> owner;
+	vector<int> extension;
+	vector<long long> ctime;
+	vector<long long> mtime;
+	vector<char> live;
+	vector<Entry*> files;
+	vector<int> freeIds;
+	
+	vector<string> ownerNames, extensionNames;
+	unordered_map<string, int> ownerIds, extensionIds;
+	
+	int intern(const string& str, unordered_map<string, int>& ids, vector<string>& names){
+		auto found = ids.find(str);
+		if (found != ids.end())
+			return found->second;
+		ids[str] = names.size();
+		names.push_back(str);
+		return names.size() - 1;
+	}
+	
+	int lookup(const string& str, unordered_map<string, int>& ids){
+		auto found = ids.find(str);
+		return found == ids.end() ? -1 : found->second;
+	}
+	
+public:
+	// the extension is whatever follows the last '.' of the name, "" if there is none
+	int add(Entry* file, const string& ownerName, long long createdTime, long long updatedTime){
+		const string& name = file->getName();
+		size_t dot = name.rfind('.');
+		int ownerId = intern(ownerName, ownerIds, ownerNames);
+		int extId = intern(dot == string::npos ? "" : name.substr(dot + 1), extensionIds, extensionNames);
+		
+		int id;
+		if (!freeIds.empty()){
+			id = freeIds.back();
+			freeIds.pop_back();
+		}
+		else {
+			id = files.size();
+			owner.push_back(0);
+			extension.push_back(0);
+			ctime.push_back(0);
+			mtime.push_back(0);
+			live.push_back(0);
+			files.push_back(NULL);
+		}
+		owner[id] = ownerId;
+		extension[id] = extId;
+		ctime[id] = createdTime;
+		mtime[id] = updatedTime;
+		live[id] = 1;
+		files[id] = file;
+		return id;
+	}
+	
+	void remove(int id){
+		live[id] = 0;
+		files[id] = NULL;
+		freeIds.push_back(id);
+	}
+	
+	const string& getOwner(int id){
+		return ownerNames[owner[id]];
+	}
+	
+	const string& getExtension(int id){
+		return extensionNames[extension[id]];
+	}
+	
+	long long getCtime(int id){
+		return ctime[id];
+	}
+	
+	long long getMtime(int id){
+		return mtime[id];
+	}
+	
+	void setMtime(int id, long long updatedTime){
+		mtime[id] = updatedTime;
+	}
+	
+	Entry* getFile(int id){
+		return files[id];
+	}
+	
+	// ids of all live files satisfying the query, one pass over the columns
+	vector<int> scan(const MetadataQuery& query){
+		vector<int> res;
+		int ownerId = -1, extId = -1;
+		if (!query.owner.empty() && (ownerId = lookup(query.owner, ownerIds)) == -1)
+			return res;
+		if (!query.extension.empty() && (extId = lookup(query.extension, extensionIds)) == -1)
+			return res;
+		
+		int n = files.size();
+		for (int i = 0; i < n; i++){
+			// non short-circuit '&' keeps the loop free of unpredictable branches
+			bool valid = live[i] & 
+			             (ownerId < 0 || owner[i] == ownerId) & (extId < 0 || extension[i] == extId) &
+			             (ctime[i] >= query.minCtime) & (ctime[i] <= query.maxCtime) &
+			             (mtime[i] >= query.minMtime) & (mtime[i] <= query.maxMtime);
+			if (valid)
+				res.push_back(i);
+		}
+		return res;
+	}
+};
+
+
 //--------------------------- Implementation of File class -----------------------
 class File : public Entry {
 private:
     int size;
+    
+    // metadata other than the size is kept in the FileSystem's column table under this id
+    // a file that was never attached to a table has the defaults of addFile: no owner, times 0
+    FileMetadataTable* metadata;
+    int id;
+    
+    static const string& noMetadata(){
+        static const string empty;
+        return empty;
+    }
 public:
     File(string name, int size) : Entry(name){
         this->size = size;
+        this->metadata = NULL;
+        this->id = -1;
+    }
+    
+    void attachMetadata(FileMetadataTable* metadata, int id){
+        this->metadata = metadata;
+        this->id = id;
+    }
+    
+    int getId(){
+        return id;
+    }
+    
+    const string& getOwner(){
+        return metadata != NULL ? metadata->getOwner(id) : noMetadata();
+    }
+    
+    const string& getExtension(){
+        return metadata != NULL ? metadata->getExtension(id) : noMetadata();
+    }
+    
+    long long getCtime(){
+        return metadata != NULL ? metadata->getCtime(id) : 0;
+    }
+    
+    long long getMtime(){
+        return metadata != NULL ? metadata->getMtime(id) : 0;
     }
     
     bool isFile() override {
@@ -80,6 +265,10 @@ public:
 	int getSize(){
 		return this->size;
 	}
+	
+	void append(int bytes){
+		this->size += bytes;
+	}
 };
 
 //-------------------------- Implementation of Directory class--------------------
@@ -87,23 +276,76 @@ class Directory : public Entry {
 private:
     unordered_map<string, Entry*> children; // now it is private
     unordered_map<string, Entry*>::iterator it; // add an iterator field
+    
+    // aggregates over all files in this subtree, maintained by FileSystem along the ancestor path
+    int fileCount;
+    long long totalSize;
+    int maxSize;
 public:
-    Directory(string name) : Entry(name) {}
+    Directory(string name) : Entry(name) {
+        fileCount = 0;
+        totalSize = 0;
+        maxSize = 0;
+    }
+    
+    ~Directory() {
+        for (auto& m : children)
+            delete m.second;
+    }
     
     bool isFile() override {
         return false;
     }
     
-    Entry* findChild(string childName) {
-        if (children.count(childName))
-            return children[childName];
+    Entry* findChild(const string& childName) {
+        auto found = children.find(childName);
+        if (found != children.end())
+            return found->second;
         return NULL;
     }
     
     void addChild(Entry* child){
+        child->setParent(this);
         children[child->getName()] = child;
     }
     
+    // make room for "n" more children so a bulk insert does not rehash on the way
+    void reserveChildren(size_t n){
+        // reserve() may rehash even when there is room, so only call it when the map must grow
+        if (children.size() + n > children.bucket_count() * children.max_load_factor())
+            children.reserve(children.size() + n);
+    }
+    
+    int getFileCount(){
+        return fileCount;
+    }
+    
+    long long getTotalSize(){
+        return totalSize;
+    }
+    
+    int getMaxSize(){
+        return maxSize;
+    }
+    
+    // a file of (new) size "fileSize" changed this subtree by "countDelta" files and "sizeDelta" bytes
+    void updateStats(int countDelta, long long sizeDelta, int fileSize){
+        fileCount += countDelta;
+        totalSize += sizeDelta;
+        maxSize = max(maxSize, fileSize);
+    }
+    
+    // only needed when a file shrinks, the children's own maxSize must already be correct
+    void recomputeMaxSize(){
+        maxSize = 0;
+        for (auto& m : children){
+            if (m.second->isFile())
+                maxSize = max(maxSize, ((File*)m.second)->getSize());
+            else
+                maxSize = max(maxSize, ((Directory*)m.second)->getMaxSize());
+        }
+    }
+    
     // iterators to facillicate iterating through the private hashMap children 
     void beginIter(){
     	it = children.begin();
@@ -122,10 +364,144 @@ public:
 
 
 
+//-------------------------- Implementation of name matching helpers ------------------------------
+// All helpers work on the characters of the name in place and never build temporary strings.
+// memcmp / memchr are vectorized by the C library, which gives us the SIMD speed-up for free.
+bool hasPrefix(const string& name, const string& prefix){
+	return name.size() >= prefix.size() && 
+	       memcmp(name.data(), prefix.data(), prefix.size()) == 0;
+}
+
+bool hasSuffix(const string& name, const string& suffix){
+	return name.size() >= suffix.size() && 
+	       memcmp(name.data() + name.size() - suffix.size(), suffix.data(), suffix.size()) == 0;
+}
+
+bool containsPattern(const string& name, const string& pattern){
+	if (pattern.empty())
+		return true;
+	const char* curr = name.data();
+	const char* end = name.data() + name.size();
+	size_t len = pattern.size();
+	while ((size_t)(end - curr) >= len){
+		// jump to the next occurrence of the first character, then compare the rest
+		curr = (const char*)memchr(curr, pattern[0], end - curr - len + 1);
+		if (curr == NULL)
+			return false;
+		if (memcmp(curr + 1, pattern.data() + 1, len - 1) == 0)
+			return true;
+		curr++;
+	}
+	return false;
+}
+
+/* glob matching: '*' matches any sequence of characters (including empty), '?' matches one character.
+   Greedy scan which backtracks to the last '*' seen on mismatch, O(n * m) worst case, no recursion. */
+bool globMatch(const string& name, const string& pattern){
+	size_t n = 0, p = 0;
+	size_t starIdx = string::npos, starMatch = 0;
+	while (n < name.size()){
+		// '*' in the pattern is always a wildcard, even against a literal '*' in the name
+		if (p < pattern.size() && pattern[p] == '*'){
+			starIdx = p++;
+			starMatch = n;
+		}
+		else if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])){
+			n++;
+			p++;
+		}
+		else if (starIdx != string::npos){
+			// let the last '*' swallow one more character and retry
+			p = starIdx + 1;
+			n = ++starMatch;
+		}
+		else
+			return false;
+	}
+	while (p < pattern.size() && pattern[p] == '*')
+		p++;
+	return p == pattern.size();
+}
+
+/* Aho-Corasick automaton for "does the name contain any of these patterns".
+   The failure links are folded into a full transition table at construction time,
+   so matching is exactly one table lookup per character of the name. */
+class AhoCorasick {
+private:
+	vector<array<int, 256>> next;   // next[state][char] -> state
+	vector<bool> terminal;          // some pattern ends at (or is a suffix of) this state
+	
+	int newState(){
+		array<int, 256> row;
+		row.fill(-1);
+		next.push_back(row);
+		terminal.push_back(false);
+		return next.size() - 1;
+	}
+	
+public:
+	AhoCorasick(const vector<string>& patterns){
+		newState(); // root
+		for (const string& p : patterns){
+			int curr = 0;
+			for (unsigned char c : p){
+				if (next[curr][c] == -1){
+					int state = newState();
+					next[curr][c] = state;
+				}
+				curr = next[curr][c];
+			}
+			terminal[curr] = true;
+		}
+		
+		// BFS to compute failure links and complete the transition table
+		vector<int> fail(next.size(), 0);
+		vector<int> queue;
+		for (int c = 0; c < 256; c++){
+			if (next[0][c] == -1)
+				next[0][c] = 0;
+			else
+				queue.push_back(next[0][c]);
+		}
+		for (size_t i = 0; i < queue.size(); i++){
+			int state = queue[i];
+			terminal[state] = terminal[state] || terminal[fail[state]];
+			for (int c = 0; c < 256; c++){
+				int child = next[state][c];
+				if (child == -1)
+					next[state][c] = next[fail[state]][c];
+				else {
+					fail[child] = next[fail[state]][c];
+					queue.push_back(child);
+				}
+			}
+		}
+	}
+	
+	bool matchAny(const string& text) const {
+		if (terminal[0])
+			return true; // an empty pattern matches everything
+		int state = 0;
+		for (unsigned char c : text){
+			state = next[state][c];
+			if (terminal[state])
+				return true;
+		}
+		return false;
+	}
+};
+
+
+
 //-------------------------- Implementation of Filter abstract class ------------------------------
 class Filter {
 public:
-	virtual bool isValid(File* file) = 0;		
+	virtual bool isValid(File* file) = 0;
+	
+	// return false only if NO file under the directory can be valid, so the search can skip the whole subtree
+	virtual bool mayMatch(Directory*) {
+		return true;
+	}
 };
 
 //--------------------- Implementation of different kinds of Filters----------
@@ -140,6 +516,10 @@ public:
 	bool isValid(File* file) override {
 		return file->getSize() >= targetSize;
 	}
+	
+	bool mayMatch(Directory* dir) override {
+		return dir->getMaxSize() >= targetSize;
+	}
 };
 
 class prefixFilter : public Filter {
@@ -150,13 +530,114 @@ public:
 		this->prefix = prefix;
 	}
 	
+	// an empty prefix matches no file, as the original substr loop (starting at length 1) did
 	bool isValid(File* file) override {
-		string name = file->getName();
-		for (int i = 1; i <= name.size(); i++){
-			if (name.substr(0, i) == prefix)
-				return true;
-		}
-		return false;
+		return !prefix.empty() && hasPrefix(file->getName(), prefix);
+	}
+};
+
+class suffixFilter : public Filter {
+private:
+	string suffix;
+public:
+	suffixFilter(string suffix){
+		this->suffix = suffix;
+	}
+	
+	bool isValid(File* file) override {
+		return hasSuffix(file->getName(), suffix);
+	}
+};
+
+class substringFilter : public Filter {
+private:
+	string pattern;
+public:
+	substringFilter(string pattern){
+		this->pattern = pattern;
+	}
+	
+	bool isValid(File* file) override {
+		return containsPattern(file->getName(), pattern);
+	}
+};
+
+class globFilter : public Filter {
+private:
+	string pattern;
+public:
+	globFilter(string pattern){
+		this->pattern = pattern;
+	}
+	
+	bool isValid(File* file) override {
+		return globMatch(file->getName(), pattern);
+	}
+};
+
+// valid if the name contains ANY of the given patterns, one pass over the name
+class anyPatternFilter : public Filter {
+private:
+	AhoCorasick matcher;
+public:
+	anyPatternFilter(const vector<string>& patterns) : matcher(patterns) {}
+	
+	bool isValid(File* file) override {
+		return matcher.matchAny(file->getName());
+	}
+};
+
+class ownerFilter : public Filter {
+private:
+	string owner;
+public:
+	ownerFilter(string owner){
+		this->owner = owner;
+	}
+	
+	bool isValid(File* file) override {
+		return file->getOwner() == owner;
+	}
+};
+
+class extensionFilter : public Filter {
+private:
+	string extension;
+public:
+	extensionFilter(string extension){
+		this->extension = extension;
+	}
+	
+	bool isValid(File* file) override {
+		return file->getExtension() == extension;
+	}
+};
+
+// files created at or after "since"
+class ctimeFilter : public Filter {
+private:
+	long long since;
+public:
+	ctimeFilter(long long since){
+		this->since = since;
+	}
+	
+	bool isValid(File* file) override {
+		return file->getCtime() >= since;
+	}
+};
+
+// files last updated at or after "since"
+class mtimeFilter : public Filter {
+private:
+	long long since;
+public:
+	mtimeFilter(long long since){
+		this->since = since;
+	}
+	
+	bool isValid(File* file) override {
+		return file->getMtime() >= since;
 	}
 };
 
@@ -173,6 +654,10 @@ public:
 	bool isValid(File* file) override {
 		return f1->isValid(file) && f2->isValid(file);
 	}
+	
+	bool mayMatch(Directory* dir) override {
+		return f1->mayMatch(dir) && f2->mayMatch(dir);
+	}
 };
 
 
@@ -189,15 +674,140 @@ public:
 	bool isValid(File* file) override {
 		return f1->isValid(file) || f2->isValid(file);
 	}
+	
+	bool mayMatch(Directory* dir) override {
+		return f1->mayMatch(dir) || f2->mayMatch(dir);
+	}
 };
 
 
 
 
 // ---------------------- Implementation of FileSystem class -----------------------------
+// "du" style answer for a path: number of files, total bytes and the largest file under it
+struct SubtreeStats {
+	int fileCount;
+	long long totalSize;
+	int maxSize;
+};
+
+// metadata field a top-K search is ranked on
+enum SortKey {
+	BY_SIZE, BY_CTIME, BY_MTIME
+};
+
+// one result of a top-K search
+struct FileRecord {
+	string path;
+	int size;
+	string owner;
+	long long ctime;
+	long long mtime;
+};
+
+/* Keeps the best K (key, record) pairs seen so far in a heap whose top is the WORST kept pair,
+   so a candidate that cannot get in costs a single comparison and memory never goes beyond K. */
+class TopKHeap {
+private:
+	size_t k;
+	bool largest;
+	vector<pair<long long, FileRecord>> heap;
+	
+	bool better(long long a, long long b) const {
+		return largest ? a > b : a < b;
+	}
+	
+public:
+	TopKHeap(size_t k, bool largest){
+		this->k = k;
+		this->largest = largest;
+		// "k" comes from the caller and may be far more than will ever match
+		heap.reserve(min(k, (size_t)1024));
+	}
+	
+	bool keepsLargest() const {
+		return largest;
+	}
+	
+	// would a file with this key be kept?
+	bool accepts(long long key) const {
+		return heap.size() < k || (k > 0 && better(key, heap.front().first));
+	}
+	
+	void push(long long key, const FileRecord& record){
+		auto worstOnTop = [this](const pair<long long, FileRecord>& a, const pair<long long, FileRecord>& b){
+			return better(a.first, b.first);
+		};
+		if (heap.size() == k){
+			pop_heap(heap.begin(), heap.end(), worstOnTop);
+			heap.back() = make_pair(key, record);
+		}
+		else
+			heap.push_back(make_pair(key, record));
+		push_heap(heap.begin(), heap.end(), worstOnTop);
+	}
+	
+	// the kept records, best first (empties the heap)
+	vector<FileRecord> sorted(){
+		auto worstOnTop = [this](const pair<long long, FileRecord>& a, const pair<long long, FileRecord>& b){
+			return better(a.first, b.first);
+		};
+		sort_heap(heap.begin(), heap.end(), worstOnTop);
+		vector<FileRecord> res;
+		for (auto& h : heap)
+			res.push_back(h.second);
+		heap.clear();
+		return res;
+	}
+};
+
+// one line of a manifest: "<path>\t<size>[\t<owner>\t<ctime>\t<mtime>]"
+struct ManifestEntry {
+	string path;
+	int size;
+	string owner;
+	long long ctime;
+	long long mtime;
+};
+
+// returns false for blank or malformed lines, which the bulk loader skips
+// every numeric field has to be consumed whole, "12abc" is not a size
+bool parseManifestLine(const string& line, ManifestEntry& entry){
+	size_t tab = line.find('\t');
+	if (tab == string::npos || tab == 0 || line[tab - 1] == '/')
+		return false;
+	const char* sizeStr = line.c_str() + tab + 1;
+	char* sizeEnd;
+	long size = strtol(sizeStr, &sizeEnd, 10);
+	if (sizeEnd == sizeStr || (*sizeEnd != '\t' && *sizeEnd != '\0') || size < 0 || size > INT_MAX)
+		return false;
+	entry.path.assign(line, 0, tab);
+	entry.size = (int)size;
+	entry.owner.clear();
+	entry.ctime = entry.mtime = 0;
+	
+	// the metadata columns are optional
+	if (*sizeEnd != '\t')
+		return true;
+	const char* ownerStr = sizeEnd + 1;
+	const char* ownerEnd = strchr(ownerStr, '\t');
+	if (ownerEnd == NULL)
+		return false;
+	entry.owner.assign(ownerStr, ownerEnd);
+	const char* ctimeStr = ownerEnd + 1;
+	char* timeEnd;
+	entry.ctime = strtoll(ctimeStr, &timeEnd, 10);
+	if (timeEnd == ctimeStr || *timeEnd != '\t')
+		return false;
+	const char* mtimeStr = timeEnd + 1;
+	entry.mtime = strtoll(mtimeStr, &timeEnd, 10);
+	return timeEnd != mtimeStr && *timeEnd == '\0';
+}
+
 class FileSystem {
 private:
     Directory* root;
+    FileMetadataTable metadata;
     
     vector<string> tokenize(const string& path){
         istringstream iss(path);
@@ -209,15 +819,46 @@ private:
         return dirs;
     }
     
-    Entry* findEntry(vector<string>& dirs){
+    // every component of "path" has to exist and all but the last must be directories
+    // (mkdir and addFile keep the empty name before the leading '/' as a directory, it is only skipped
+    // while nothing has been created under it)
+    Entry* lookup(const string& path){
         Entry* curr = root;
-        for (string dir : dirs){
-            if (((Directory*)curr)->findChild(dir) != NULL)
-                curr = ((Directory*)curr)->findChild(dir);
+        for (string& name : tokenize(path)){
+            Entry* child = curr->isFile() ? NULL : ((Directory*)curr)->findChild(name);
+            if (child != NULL)
+                curr = child;
+            else if (!name.empty() || curr->isFile())
+                throw invalid_argument("no such file or directory: " + path);
         }
         return curr;
     }
     
+    // every directory passed through (root first), missing components are skipped
+    vector<Directory*> findPath(vector<string>& dirs){
+        vector<Directory*> path{root};
+        for (string& dir : dirs){
+            Entry* child = path.back()->findChild(dir);
+            if (child != NULL && !child->isFile())
+                path.push_back((Directory*)child);
+        }
+        return path;
+    }
+    
+    // full path of "entry", in the same form searchTopK reports
+    string pathOf(Entry* entry){
+        vector<Entry*> up;
+        for (; entry != root; entry = entry->getParent())
+            up.push_back(entry);
+        string path;
+        for (int i = up.size() - 1; i >= 0; i--){
+            if (i < (int)up.size() - 1)
+                path += '/';
+            path += up[i]->getName();
+        }
+        return path;
+    }
+    
     void search(Entry* node, Filter& filter, vector<string>& res){
     	if (node->isFile()){
     		if (filter.isValid((File*)node))
@@ -225,16 +866,152 @@ private:
     		return;
 		}
 		
+		if (!filter.mayMatch((Directory*)node))
+			return;
 		((Directory*)node)->beginIter();
 		while(((Directory*)node)->hasNext())
 			search(((Directory*)node)->next(), filter, res);
 	}
     
+    long long sortKeyOf(File* file, SortKey key){
+    	if (key == BY_SIZE)
+    		return file->getSize();
+    	if (key == BY_CTIME)
+    		return file->getCtime();
+    	return file->getMtime();
+	}
+    
+    // same DFS as search(), "path" is the full path of "node" and records are only built for files
+    // that make it into the heap
+    void searchTopK(Entry* node, string& path, Filter& filter, SortKey key, TopKHeap& top){
+    	if (node->isFile()){
+    		File* file = (File*)node;
+    		long long value = sortKeyOf(file, key);
+    		if (top.accepts(value) && filter.isValid(file))
+    			top.push(value, FileRecord{path, file->getSize(), file->getOwner(), file->getCtime(), file->getMtime()});
+    		return;
+		}
+		
+		Directory* dir = (Directory*)node;
+		if (!filter.mayMatch(dir))
+			return;
+		// ranking by largest size, a subtree whose largest file cannot get in is skipped
+		if (key == BY_SIZE && top.keepsLargest() && !top.accepts(dir->getMaxSize()))
+			return;
+		dir->beginIter();
+		while(dir->hasNext()){
+			Entry* child = dir->next();
+			size_t len = path.size();
+			path += '/';
+			path += child->getName();
+			searchTopK(child, path, filter, key, top);
+			path.resize(len);
+		}
+	}
+    
+    // "path" holds every directory from root down to the parent of the new file
+    void insertFile(vector<Directory*>& path, const string& fileName, int fileSize,
+                    const string& owner, long long ctime, long long mtime){
+        Directory* parent = path.back();
+        
+        // adding an existing file name replaces the old file, a directory of that name is kept
+        Entry* old = parent->findChild(fileName);
+        if (old != NULL && !old->isFile())
+            throw invalid_argument("is a directory: " + fileName);
+        int countDelta = 1, oldSize = 0;
+        if (old != NULL){
+            countDelta = 0;
+            oldSize = ((File*)old)->getSize();
+            metadata.remove(((File*)old)->getId());
+            delete old;
+        }
+        File* file = new File(fileName, fileSize);
+        file->attachMetadata(&metadata, metadata.add(file, owner, ctime, mtime));
+        parent->addChild(file);
+        
+        for (int i = path.size() - 1; i >= 0; i--){
+            path[i]->updateStats(countDelta, fileSize - oldSize, fileSize);
+            if (fileSize < oldSize)
+                path[i]->recomputeMaxSize();
+        }
+    }
+    
+    // parse lines[0, n) into entries, striped over "numThreads" threads when asked to
+    void parseBatch(vector<string>& lines, size_t n, vector<ManifestEntry>& entries, 
+                    vector<char>& valid, int numThreads){
+        auto parseRange = [&](size_t begin, size_t end){
+            for (size_t i = begin; i < end; i++)
+                valid[i] = parseManifestLine(lines[i], entries[i]);
+        };
+        if (numThreads <= 1 || n < 1024){
+            parseRange(0, n);
+            return;
+        }
+        vector<thread> workers;
+        for (int t = 0; t < numThreads; t++)
+            workers.push_back(thread(parseRange, n * t / numThreads, n * (t + 1) / numThreads));
+        for (thread& worker : workers)
+            worker.join();
+    }
+    
+    /* Insert one manifest entry starting from the cursor left by the previous entry.
+       cursorNames[i] is the i-th directory component of the previous path and cursorDirs[i + 1]
+       the Directory it resolved to (cursorDirs[0] is root). Components shared with the previous
+       path are matched by a plain string compare, only the differing tail is looked up (and
+       created if missing, like "mkdir -p"). "runLength" > 0 pre-sizes the parent's children. */
+    void loadEntry(const ManifestEntry& entry, size_t runLength,
+                   vector<string>& cursorNames, vector<Directory*>& cursorDirs){
+        const string& path = entry.path;
+        size_t start = 0, depth = 0;
+        bool onCursor = true;
+        while (true){
+            size_t end = path.find('/', start);
+            if (end == string::npos)
+                break;
+            size_t len = end - start;
+            if (onCursor && depth < cursorNames.size() && 
+                cursorNames[depth].compare(0, string::npos, path, start, len) == 0){
+                depth++;
+                start = end + 1;
+                continue;
+            }
+            if (onCursor){
+                cursorNames.resize(depth);
+                cursorDirs.resize(depth + 1);
+                onCursor = false;
+            }
+            Directory* parent = cursorDirs.back();
+            string name(path, start, len);
+            Entry* child = parent->findChild(name);
+            if (child == NULL){
+                child = new Directory(name);
+                parent->addChild(child);
+            }
+            else if (child->isFile())
+                throw invalid_argument("not a directory in manifest path: " + path);
+            cursorNames.push_back(name);
+            cursorDirs.push_back((Directory*)child);
+            depth++;
+            start = end + 1;
+        }
+        // the new path may be shallower than the previous one
+        cursorNames.resize(depth);
+        cursorDirs.resize(depth + 1);
+        
+        if (runLength > 0)
+            cursorDirs.back()->reserveChildren(runLength);
+        insertFile(cursorDirs, path.substr(start), entry.size, entry.owner, entry.ctime, entry.mtime);
+    }
+    
 public:
     FileSystem() {
         root = new Directory("Root");
     }
     
+    ~FileSystem() {
+        delete root;
+    }
+    
     void mkdir(string path) {
         vector<string> dirs = tokenize(path);
         Entry* curr = root;
@@ -246,14 +1023,117 @@ public:
         }
     }
     
-    void addFile(string filePath, int fileSize) {
+    void addFile(string filePath, int fileSize, string owner = "", long long ctime = 0, long long mtime = 0) {
+        vector<string> dirs = tokenize(filePath);
+        string fileName = dirs.back();
+        dirs.pop_back();
+        
+        vector<Directory*> path = findPath(dirs);
+        insertFile(path, fileName, fileSize, owner, ctime, mtime);
+    }
+    
+    // grow an existing file by "bytes", the aggregates of all its ancestors follow in O(depth)
+    // a non-negative "mtime" also becomes the file's last updated time
+    void appendToFile(string filePath, int bytes, long long mtime = -1) {
+        if (bytes < 0)
+            throw invalid_argument("cannot append a negative number of bytes");
         vector<string> dirs = tokenize(filePath);
         string fileName = dirs.back();
         dirs.pop_back();
         
-        Entry* curr = findEntry(dirs);
+        vector<Directory*> path = findPath(dirs);
+        Entry* entry = path.back()->findChild(fileName);
+        if (entry == NULL || !entry->isFile())
+            throw invalid_argument("no such file: " + filePath);
+        
+        File* file = (File*)entry;
+        file->append(bytes);
+        if (mtime >= 0)
+            metadata.setMtime(file->getId(), mtime);
+        for (Directory* dir : path)
+            dir->updateStats(0, bytes, file->getSize());
+    }
+    
+    /* Build the tree from a manifest stream with one "<path>\t<size>[\t<owner>\t<ctime>\t<mtime>]"
+       line per file, missing directories are created on the way. Lines are parsed in batches, in parallel
+       when parseThreads > 1, and each batch is applied in path order (stable, so a repeated path still
+       ends with its last size) so consecutive entries share the parent cursor whatever the input order.
+       The tree itself is always built by the calling thread.
+       Returns the number of files loaded. Malformed lines are skipped, and so are lines that would put
+       a file where a directory is or the other way round, the rest of the manifest still loads. */
+    long long bulkLoad(istream& manifest, int parseThreads = 1) {
+        const size_t batchSize = 1 << 16;
+        vector<string> lines(batchSize);
+        vector<ManifestEntry> entries(batchSize);
+        vector<char> valid(batchSize);
+        vector<size_t> order;
+        vector<string> cursorNames;
+        vector<Directory*> cursorDirs{root};
+        long long loaded = 0;
         
-        ((Directory*)curr)->addChild(new File(fileName, fileSize));
+        while (true){
+            size_t n = 0;
+            while (n < batchSize && getline(manifest, lines[n]))
+                n++;
+            if (n == 0)
+                break;
+            parseBatch(lines, n, entries, valid, parseThreads);
+            
+            order.clear();
+            for (size_t i = 0; i < n; i++)
+                if (valid[i])
+                    order.push_back(i);
+            auto byPath = [&](size_t a, size_t b){ return entries[a].path < entries[b].path; };
+            if (!is_sorted(order.begin(), order.end(), byPath))
+                stable_sort(order.begin(), order.end(), byPath);
+            
+            // length of the run of entries sharing the parent directory of entry order[k]
+            size_t runLength = 0;
+            const string* runDir = NULL;
+            size_t runDirLen = 0;
+            for (size_t k = 0; k < order.size(); k++){
+                const ManifestEntry& entry = entries[order[k]];
+                const string& path = entry.path;
+                size_t dirLen = path.rfind('/');
+                bool sameDir = runDir != NULL && dirLen == runDirLen && 
+                               path.compare(0, dirLen, *runDir, 0, dirLen) == 0;
+                runLength = 0;
+                if (dirLen == string::npos)
+                    runDir = NULL; // file directly under root, nothing to pre-size
+                else if (!sameDir){
+                    runDir = &path;
+                    runDirLen = dirLen;
+                    for (size_t j = k; j < order.size(); j++){
+                        const string& other = entries[order[j]].path;
+                        if (other.size() <= dirLen || other.compare(0, dirLen + 1, path, 0, dirLen + 1) != 0 ||
+                            other.find('/', dirLen + 1) != string::npos)
+                            break;
+                        runLength++;
+                    }
+                }
+                // a conflicting entry throws before anything is changed, the cursor stays valid
+                try {
+                    loadEntry(entry, runLength, cursorNames, cursorDirs);
+                    loaded++;
+                }
+                catch (invalid_argument&){
+                }
+            }
+            if (n < batchSize)
+                break;
+        }
+        return loaded;
+    }
+    
+    // O(depth) lookup of the aggregates, no traversal of the subtree; throws if "path" does not exist
+    SubtreeStats getStats(string path) {
+        Entry* entry = lookup(path);
+        if (entry->isFile()){
+            int size = ((File*)entry)->getSize();
+            return SubtreeStats{1, size, size};
+        }
+        Directory* dir = (Directory*)entry;
+        return SubtreeStats{dir->getFileCount(), dir->getTotalSize(), dir->getMaxSize()};
     }
     
     vector<string> searchTargetFiles(Filter& filter){
@@ -261,11 +1141,292 @@ public:
     	search(root, filter, res);
     	return res;
 	}
+	
+	/* The K best files under "path" that pass the filter, ranked on "key" (largest first, or smallest
+	   first when largest == false), as (path, metadata) records. Uses a bounded heap during the
+	   traversal, so memory is O(K) however many files match. Throws if "path" does not exist. */
+	vector<FileRecord> searchTopK(string path, Filter& filter, size_t k, SortKey key, bool largest = true){
+		Entry* start = lookup(path);
+		while (!path.empty() && path.back() == '/')
+			path.pop_back();
+		
+		TopKHeap top(k, largest);
+		searchTopK(start, path, filter, key, top);
+		return top.sorted();
+	}
+	
+	vector<FileRecord> searchTopK(string path, size_t k, SortKey key, bool largest = true){
+		sizeFilter anySize(0);
+		return searchTopK(path, anySize, k, key, largest);
+	}
+	
+	// metadata-only queries scan the column table instead of traversing the tree, the full paths of the
+	// matches are rebuilt from their parents
+	vector<string> searchByMetadata(const MetadataQuery& query){
+		vector<string> res;
+		for (int id : metadata.scan(query))
+			res.push_back(pathOf(metadata.getFile(id)));
+		return res;
+	}
 };
 
 
+//---------------------- benchmarks, run with "./a.out bench [N]" -------------------------
+// the original prefixFilter, kept only as the baseline for the benchmark
+class substrPrefixFilter : public Filter {
+private:
+	string prefix;
+public:
+	substrPrefixFilter(string prefix){
+		this->prefix = prefix;
+	}
+	
+	bool isValid(File* file) override {
+		string name = file->getName();
+		for (size_t i = 1; i <= name.size(); i++){
+			if (name.substr(0, i) == prefix)
+				return true;
+		}
+		return false;
+	}
+};
+
+// count the files in "files" accepted by "filter", "rounds" times over
+double timeFilter(Filter& filter, vector<File*>& files, int rounds, long long& matched){
+	auto start = chrono::steady_clock::now();
+	matched = 0;
+	for (int r = 0; r < rounds; r++){
+		for (File* file : files)
+			matched += filter.isValid(file);
+	}
+	auto end = chrono::steady_clock::now();
+	return chrono::duration<double, milli>(end - start).count();
+}
+
+void benchNameMatching(long long numNames){
+	// a pool of realistic file names which is scanned repeatedly to reach numNames checks
+	const int poolSize = 100000;
+	const char* stems[] = {"file", "node", "report", "image", "backup", "log"};
+	const char* exts[] = {".txt", ".jpg", ".cpp", ".log", ".tar.gz"};
+	vector<File*> files;
+	for (int i = 0; i < poolSize; i++){
+		string name = string(stems[i % 6]) + "_" + to_string(i * 7919 % 1000003) + exts[i % 5];
+		files.push_back(new File(name, i));
+	}
+	int rounds = max(1LL, numNames / poolSize);
+	
+	cout << "name matching over " << (long long)rounds * poolSize << " names" << endl;
+	substrPrefixFilter oldPF("report");
+	prefixFilter pF("report");
+	suffixFilter sfF(".tar.gz");
+	substringFilter ssF("_42");
+	globFilter gF("image_*3.jp?");
+	anyPatternFilter aF({"_42", "_99", "backup_1", ".cpp"});
+	
+	vector<pair<string, Filter*>> filters{{"substr prefixFilter (old)", &oldPF}, {"prefixFilter", &pF}, 
+	                                      {"suffixFilter", &sfF}, {"substringFilter", &ssF},
+	                                      {"globFilter", &gF}, {"anyPatternFilter (4 patterns)", &aF}};
+	for (auto& f : filters){
+		long long matched;
+		double ms = timeFilter(*f.second, files, rounds, matched);
+		cout << "  " << f.first << ": " << ms << " ms, " << matched << " matches" << endl;
+	}
+	
+	for (File* file : files)
+		delete file;
+}
+
+// spread numFiles files over /d<0..99>/s<0..99>, file sizes depend on the directory so some
+// subtrees only hold small files (the typical case where subtree pruning pays off)
+void buildSyntheticTree(FileSystem& fs, int numFiles){
+	for (int d = 0; d < 100; d++){
+		for (int sub = 0; sub < 100; sub++)
+			fs.mkdir("/d" + to_string(d) + "/s" + to_string(sub));
+	}
+	for (int i = 0; i < numFiles; i++){
+		int d = i % 100, sub = (i / 100) % 100;
+		int size = (d * 7 % 100) * 100 + i % 97;
+		fs.addFile("/d" + to_string(d) + "/s" + to_string(sub) + "/f" + to_string(i), size);
+	}
+}
+
+// sums the sizes it sees, which is what a du had to be before the aggregates
+class sumSizeFilter : public Filter {
+public:
+	long long total = 0;
+	bool isValid(File* file) override {
+		total += file->getSize();
+		return true;
+	}
+};
+
+// same predicate as sizeFilter, but never prunes a subtree
+class unprunedSizeFilter : public sizeFilter {
+public:
+	unprunedSizeFilter(int targetSize) : sizeFilter(targetSize) {}
+	bool mayMatch(Directory*) override {
+		return true;
+	}
+};
+
+void benchSubtreeStats(int numFiles){
+	FileSystem fs;
+	buildSyntheticTree(fs, numFiles);
+	cout << "subtree aggregates over " << numFiles << " files" << endl;
+	
+	auto start = chrono::steady_clock::now();
+	sumSizeFilter sumF;
+	fs.searchTargetFiles(sumF);
+	auto mid = chrono::steady_clock::now();
+	SubtreeStats stats = fs.getStats("/");
+	auto end = chrono::steady_clock::now();
+	cout << "  du by full search: " << chrono::duration<double, milli>(mid - start).count() << " ms, "
+	     << sumF.total << " bytes" << endl;
+	cout << "  du by aggregates:  " << chrono::duration<double, milli>(end - mid).count() << " ms, "
+	     << stats.totalSize << " bytes" << endl;
+	
+	unprunedSizeFilter fullF(9850);
+	sizeFilter prunedF(9850);
+	start = chrono::steady_clock::now();
+	size_t fullCount = fs.searchTargetFiles(fullF).size();
+	mid = chrono::steady_clock::now();
+	size_t prunedCount = fs.searchTargetFiles(prunedF).size();
+	end = chrono::steady_clock::now();
+	cout << "  size >= 9850 without pruning: " << chrono::duration<double, milli>(mid - start).count() 
+	     << " ms, " << fullCount << " files" << endl;
+	cout << "  size >= 9850 with pruning:    " << chrono::duration<double, milli>(end - mid).count() 
+	     << " ms, " << prunedCount << " files" << endl;
+}
+
+// a manifest with numFiles entries, in sorted (directory by directory) or shuffled order
+string makeManifest(int numFiles, bool sorted){
+	vector<int> order(numFiles);
+	for (int i = 0; i < numFiles; i++)
+		order[i] = i;
+	if (!sorted)
+		shuffle(order.begin(), order.end(), mt19937(42));
+	string manifest;
+	for (int i : order){
+		manifest += "/d" + to_string(i / 10000) + "/s" + to_string(i / 100 % 100) + "/f" + to_string(i);
+		manifest += "\t" + to_string(i % 4096) + "\n";
+	}
+	return manifest;
+}
+
+void benchBulkLoad(int numFiles){
+	cout << "building the tree from a manifest of " << numFiles << " files" << endl;
+	string sortedManifest = makeManifest(numFiles, true);
+	string shuffledManifest = makeManifest(numFiles, false);
+	
+	for (string* manifest : {&sortedManifest, &shuffledManifest}){
+		// baseline: one mkdir and one addFile per line
+		FileSystem fs;
+		istringstream in(*manifest);
+		string line;
+		ManifestEntry entry;
+		auto start = chrono::steady_clock::now();
+		while (getline(in, line)){
+			if (!parseManifestLine(line, entry))
+				continue;
+			fs.mkdir(entry.path.substr(0, entry.path.rfind('/')));
+			fs.addFile(entry.path, entry.size);
+		}
+		auto end = chrono::steady_clock::now();
+		cout << "  mkdir + addFile per line" << (manifest == &sortedManifest ? " sorted: " : " shuffled: ") << chrono::duration<double, milli>(end - start).count() 
+		     << " ms, " << fs.getStats("/").fileCount << " files" << endl;
+	}
+	
+	vector<pair<string, pair<string*, int>>> runs{{"bulkLoad sorted", {&sortedManifest, 1}},
+	                                              {"bulkLoad shuffled", {&shuffledManifest, 1}},
+	                                              {"bulkLoad sorted, 4 parse threads", {&sortedManifest, 4}}};
+	for (auto& run : runs){
+		FileSystem fs;
+		istringstream in(*run.second.first);
+		auto start = chrono::steady_clock::now();
+		long long loaded = fs.bulkLoad(in, run.second.second);
+		auto end = chrono::steady_clock::now();
+		cout << "  " << run.first << ": " << chrono::duration<double, milli>(end - start).count() 
+		     << " ms, " << loaded << " files" << endl;
+	}
+}
+
+void benchMetadataScan(int numFiles){
+	cout << "mtime > T AND owner == X over " << numFiles << " files" << endl;
+	FileSystem fs;
+	for (int d = 0; d < 100; d++)
+		fs.mkdir("/d" + to_string(d));
+	for (int i = 0; i < numFiles; i++){
+		string owner = "user" + to_string(i * 31 % 50);
+		fs.addFile("/d" + to_string(i % 100) + "/f" + to_string(i) + ".dat", i % 4096, owner, i, i * 7 % numFiles);
+	}
+	
+	ownerFilter owF("user7");
+	mtimeFilter mtF(numFiles / 2);
+	AndFilter andF(&mtF, &owF);
+	auto start = chrono::steady_clock::now();
+	size_t treeCount = fs.searchTargetFiles(andF).size();
+	auto mid = chrono::steady_clock::now();
+	MetadataQuery query;
+	query.owner = "user7";
+	query.minMtime = numFiles / 2;
+	size_t scanCount = fs.searchByMetadata(query).size();
+	auto end = chrono::steady_clock::now();
+	cout << "  virtual Filter traversal: " << chrono::duration<double, milli>(mid - start).count() 
+	     << " ms, " << treeCount << " files" << endl;
+	cout << "  column scan:              " << chrono::duration<double, milli>(end - mid).count() 
+	     << " ms, " << scanCount << " files" << endl;
+}
+
+// keeps (size, name) of every file it sees: the search-everything-then-sort baseline
+class collectSizeFilter : public Filter {
+public:
+	vector<pair<int, string>> all;
+	bool isValid(File* file) override {
+		all.push_back(make_pair(file->getSize(), file->getName()));
+		return false;
+	}
+};
+
+void benchTopK(int numFiles){
+	cout << "100 largest files out of " << numFiles << endl;
+	FileSystem fs;
+	buildSyntheticTree(fs, numFiles);
+	
+	auto start = chrono::steady_clock::now();
+	collectSizeFilter collectF;
+	fs.searchTargetFiles(collectF);
+	sort(collectF.all.begin(), collectF.all.end(), greater<pair<int, string>>());
+	collectF.all.resize(min((size_t)100, collectF.all.size()));
+	auto mid = chrono::steady_clock::now();
+	vector<FileRecord> top = fs.searchTopK("/", 100, BY_SIZE);
+	auto end = chrono::steady_clock::now();
+	cout << "  search + full sort: " << chrono::duration<double, milli>(mid - start).count() 
+	     << " ms, largest " << collectF.all[0].first << endl;
+	cout << "  searchTopK:         " << chrono::duration<double, milli>(end - mid).count() 
+	     << " ms, largest " << top[0].size << endl;
+	
+	start = chrono::steady_clock::now();
+	top = fs.searchTopK("/", 100, BY_MTIME);
+	end = chrono::steady_clock::now();
+	cout << "  searchTopK by mtime (no subtree pruning): " << chrono::duration<double, milli>(end - start).count() 
+	     << " ms" << endl;
+}
+
+int runBenchmarks(long long n){
+	benchNameMatching(n);
+	benchSubtreeStats((int)min(n / 10, 1000000LL));
+	benchBulkLoad((int)min(n / 10, 1000000LL));
+	benchMetadataScan((int)min(n / 10, 1000000LL));
+	benchTopK((int)min(n / 10, 1000000LL));
+	return 0;
+}
+
+
 //---------------------- main function for test purpose-------------------------
-int main() {
+int main(int argc, char* argv[]) {
+	if (argc > 1 && string(argv[1]) == "bench")
+		return runBenchmarks(argc > 2 ? atoll(argv[2]) : 10000000);
+	
 	FileSystem fs;
 	
    /* ----- build the tree structure for the file system -----------------------
@@ -282,14 +1443,14 @@ int main() {
 	fs.mkdir("/a/b/d");
 	fs.mkdir("/a/k");
 	
-	fs.addFile("/a/b/file1.txt", 10);
-	fs.addFile("/a/b/node2.txt", 5);
-	fs.addFile("/a/b/c/file3.txt", 4);
-	fs.addFile("/a/b/c/node4.txt", 16);
-	fs.addFile("/a/b/d/node5.txt", 15);
-	fs.addFile("/a/k/file6.txt", 11);
-	fs.addFile("/a/k/node7.txt", 3);
-	fs.addFile("/a/file8.txt", 20);
+	fs.addFile("/a/b/file1.txt", 10, "John Smith", 100, 150);
+	fs.addFile("/a/b/node2.txt", 5, "Jane Doe", 110, 110);
+	fs.addFile("/a/b/c/file3.txt", 4, "John Smith", 120, 300);
+	fs.addFile("/a/b/c/node4.txt", 16, "Jane Doe", 130, 200);
+	fs.addFile("/a/b/d/node5.txt", 15, "John Smith", 140, 140);
+	fs.addFile("/a/k/file6.txt", 11, "Jane Doe", 150, 400);
+	fs.addFile("/a/k/node7.txt", 3, "John Smith", 160, 250);
+	fs.addFile("/a/file8.txt", 20, "Jane Doe", 170, 170);
 	
     // ---------------Test size filter ----------------	
 	sizeFilter sF(10);
@@ -323,6 +1484,110 @@ int main() {
 		cout << str << ", ";
 	cout << endl;		
 	
+	//------------- Test name pattern filters ---------------------
+	suffixFilter sfF("5.txt");
+	v = fs.searchTargetFiles(sfF);
+	cout << "All files whose name has suffix '5.txt' : ";
+	for (string str : v)
+		cout << str << ", ";
+	cout << endl;
+	
+	globFilter gF("node?.t*");
+	v = fs.searchTargetFiles(gF);
+	cout << "All files whose name matches 'node?.t*' : ";
+	for (string str : v)
+		cout << str << ", ";
+	cout << endl;
+	
+	anyPatternFilter apF({"e1", "e4", "e8"});
+	v = fs.searchTargetFiles(apF);
+	cout << "All files whose name contains 'e1', 'e4' or 'e8' : ";
+	for (string str : v)
+		cout << str << ", ";
+	cout << endl;
+	
+	//------------- Test subtree aggregates ---------------------
+	SubtreeStats st = fs.getStats("/a/b");
+	cout << "/a/b has " << st.fileCount << " files, " << st.totalSize << " bytes, largest " << st.maxSize << endl;
+	fs.appendToFile("/a/k/node7.txt", 30);
+	st = fs.getStats("/a/k");
+	cout << "/a/k after appending 30 bytes to node7.txt: " << st.fileCount << " files, " 
+	     << st.totalSize << " bytes, largest " << st.maxSize << endl;
+	fs.addFile("/a/k/node7.txt", 3, "John Smith", 160, 250);
+	st = fs.getStats("/a");
+	cout << "/a after truncating node7.txt back to 3: " << st.fileCount << " files, " 
+	     << st.totalSize << " bytes, largest " << st.maxSize << endl;
+	
+	//------------- Test metadata filters and the column scan ---------------------
+	ownerFilter owF("John Smith");
+	mtimeFilter mtF(200);
+	AndFilter omF(&owF, &mtF);
+	v = fs.searchTargetFiles(omF);
+	cout << "All files owned by 'John Smith' AND updated at or after 200 : ";
+	for (string str : v)
+		cout << str << ", ";
+	cout << endl;
+	
+	MetadataQuery query;
+	query.owner = "John Smith";
+	query.minMtime = 200;
+	v = fs.searchByMetadata(query);
+	cout << "Same query by column scan : ";
+	for (string str : v)
+		cout << str << ", ";
+	cout << endl;
+	
+	//------------- Test top-K searches ---------------------
+	vector<FileRecord> top = fs.searchTopK("/a/b", 3, BY_SIZE);
+	cout << "3 largest files under /a/b : ";
+	for (FileRecord& r : top)
+		cout << r.path << " (" << r.size << "), ";
+	cout << endl;
+	
+	top = fs.searchTopK("/a", pF, 2, BY_MTIME);
+	cout << "2 most recently updated files under /a with prefix 'file' : ";
+	for (FileRecord& r : top)
+		cout << r.path << " (" << r.owner << ", mtime " << r.mtime << "), ";
+	cout << endl;
+	
+	top = fs.searchTopK("/", 2, BY_CTIME, false);
+	cout << "2 oldest files : ";
+	for (FileRecord& r : top)
+		cout << r.path << " (ctime " << r.ctime << "), ";
+	cout << endl;
+	cout << "searchTopK with k = SIZE_MAX finds all " << fs.searchTopK("/", SIZE_MAX, BY_SIZE).size() << " files" << endl;
+	try {
+		fs.searchTopK("/a/bb", 3, BY_SIZE);
+	}
+	catch (invalid_argument& e){
+		cout << "searchTopK(\"/a/bb\"): " << e.what() << endl;
+	}
+	
+	//------------- Test bulk loading from a manifest ---------------------
+	FileSystem loadedFs;
+	istringstream manifest("/x/y/file1.txt\t12\tJohn Smith\t5\t9\n/x/y/file2.txt\t7\n/x/z/node3.txt\t30\n"
+	                       "not a manifest line\n/x/y/w/file4.txt\t9\n/x/file5.txt\t1\n");
+	long long loaded = loadedFs.bulkLoad(manifest);
+	st = loadedFs.getStats("/x");
+	try {
+		loadedFs.getStats("/x/no/such/dir");
+	}
+	catch (invalid_argument& e){
+		cout << "getStats(\"/x/no/such/dir\"): " << e.what() << endl;
+	}
+	cout << "bulk loaded " << loaded << " files, /x has " << st.fileCount << " files, "
+	     << st.totalSize << " bytes, largest " << st.maxSize << endl;
+	v = loadedFs.searchTargetFiles(pF);
+	cout << "Bulk loaded files whose name has prefix of 'file': ";
+	for (string str : v)
+		cout << str << ", ";
+	cout << endl;
+	v = loadedFs.searchTargetFiles(owF);
+	cout << "Bulk loaded files owned by 'John Smith': ";
+	for (string str : v)
+		cout << str << ", ";
+	cout << endl;
+	
 	
 	return 0;
 }
@@ -52,7 +52,7 @@ public:
     Entry(const string& name){
         this->name = name;
     }
-    string getName(){
+    const string& getName(){
         return name;
     }
     virtual bool isFile() = 0;    
@@ -126,13 +126,10 @@ public:
 		this->prefix = prefix;
 	}
 	
+	// an empty prefix matches no file, as the original substr loop (starting at length 1) did
 	bool isValid(File* file) override {
-		string name = file->getName();
-		for (int i = 1; i <= name.size(); i++){
-			if (name.substr(0, i) == prefix)
-				return true;
-		}
-		return false;
+		const string& name = file->getName();
+		return !prefix.empty() && name.size() >= prefix.size() && name.compare(0, prefix.size(), prefix) == 0;
 	}
 };
 